@@ -0,0 +1,528 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+// the AVX2 kernels are compiled for any x86 target (by GCC and Clang with the target
+// attribute, MSVC needs no /arch:AVX2 for the intrinsics) and chosen at runtime
+#if defined(__AVX2__) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))) \
+	|| (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define AGGREGATE_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGGREGATE_SSE2 1
+#endif
+#if defined(AGGREGATE_AVX2) || defined(AGGREGATE_SSE2)
+#include <immintrin.h>
+#endif
+#if defined(AGGREGATE_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// marks a function that uses AVX2 intrinsics (call it only if the CPU supports AVX2)
+#if defined(AGGREGATE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define AGGREGATE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AGGREGATE_TARGET_AVX2
+#endif
+
+// Aggregate kernels over customer values
+// sum, minimum and maximum (in one pass), histograms of the buckets 0..999 that
+// create_customer() draws from and the k largest values, either over a flat buffer of
+// values (e.g. CustomerTable::all_values()) or over a collection of customers
+// (anything with get_values() returning contiguous ints):
+//
+//		aggregate::summary s = aggregate::summarize(table.all_values());
+//		std::vector<int> top = aggregate::parallel_top_k(customers, 10);
+//
+// summarize() and top_k() use AVX2 if the CPU supports it (checked once at startup, no
+// -mavx2 or /arch:AVX2 needed), else SSE2 if the compiler targets it, else scalar code;
+// the kernel can also be chosen explicitly (isa, a kind the CPU lacks falls back to best_isa).
+// The histogram stays scalar: without a conflict-free scatter (AVX-512) the increments
+// can't be vectorized.
+// The parallel_...() versions split the values (or customers) into one chunk per thread
+// and combine the partial results.
+// Over a std::vector<Customer> every customer has its own small block of values, so most of
+// the SIMD advantage is lost there; a flat buffer is what the kernels are made for.
+namespace aggregate
+{
+	enum class isa { scalar, sse2, avx2 };
+
+	namespace detail
+	{
+		inline bool cpu_has_avx2() noexcept
+		{
+#if defined(__AVX2__)
+			return true;
+#elif defined(AGGREGATE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+			__builtin_cpu_init();		// may run before the constructor of libgcc
+			return __builtin_cpu_supports("avx2");
+#elif defined(AGGREGATE_AVX2)
+			// AVX2 (leaf 7, EBX bit 5), and the OS saves the YMM registers (OSXSAVE, XCR0 bits 1 and 2)
+			int regs[4];
+			__cpuid(regs, 1);
+			if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+				return false;
+			}
+			__cpuid(regs, 0);
+			if (regs[0] < 7) {
+				return false;
+			}
+			__cpuidex(regs, 7, 0);
+			return (regs[1] & (1 << 5)) != 0;
+#else
+			return false;
+#endif
+		}
+
+		inline isa detect_isa() noexcept
+		{
+#if defined(AGGREGATE_AVX2)
+			if (cpu_has_avx2()) {
+				return isa::avx2;
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			return isa::sse2;
+#else
+			return isa::scalar;
+#endif
+		}
+	}
+
+	// the best kernels compiled in and supported by this CPU
+	inline const isa best_isa = detail::detect_isa();
+
+	// whether the kernels for kind were compiled in and the CPU supports them
+	inline bool available(isa kind) noexcept
+	{
+		return kind <= best_isa;
+	}
+
+	// kind, or best_isa if the CPU doesn't support kind
+	inline isa usable(isa kind) noexcept
+	{
+		return std::min(kind, best_isa);
+	}
+
+	constexpr const char* name(isa kind) noexcept
+	{
+		switch (kind) {
+		case isa::scalar:
+			return "scalar";
+		case isa::sse2:
+			return "SSE2";
+		case isa::avx2:
+			return "AVX2";
+		}
+		return "?";
+	}
+
+	struct summary {
+		std::size_t	count{ 0 };
+		long long	sum{ 0 };
+		int			min{ INT_MAX };
+		int			max{ INT_MIN };
+
+		double mean() const noexcept
+		{
+			return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+		}
+
+		summary& operator+= (const summary& s) noexcept
+		{
+			count += s.count;
+			sum += s.sum;
+			min = std::min(min, s.min);
+			max = std::max(max, s.max);
+			return *this;
+		}
+		friend bool operator== (const summary&, const summary&) = default;
+	};
+
+	inline constexpr std::size_t buckets = 1000;
+
+	struct histogram {
+		std::array<std::size_t, buckets> counts{};
+		std::size_t out_of_range{ 0 };		// values outside 0..buckets-1
+
+		histogram& operator+= (const histogram& h) noexcept
+		{
+			for (std::size_t i = 0; i < buckets; ++i) {
+				counts[i] += h.counts[i];
+			}
+			out_of_range += h.out_of_range;
+			return *this;
+		}
+		friend bool operator== (const histogram&, const histogram&) = default;
+	};
+
+	// collections of customers with contiguous values
+	template <typename Customers>
+	concept customer_range = requires(const Customers& coll) {
+		std::size(coll);
+		{ std::data(coll[0].get_values()) } -> std::convertible_to<const int*>;
+		std::size(coll[0].get_values());
+	};
+
+	namespace detail
+	{
+		template <typename Customer>
+		std::span<const int> values_of(const Customer& cust)
+		{
+			const auto& values = cust.get_values();
+			return { std::data(values), std::size(values) };
+		}
+
+		inline void summarize_scalar(summary& res, std::span<const int> values) noexcept
+		{
+			long long sum = 0;
+			int lo = res.min;
+			int hi = res.max;
+			for (int val : values) {
+				sum += val;
+				lo = std::min(lo, val);
+				hi = std::max(hi, val);
+			}
+			res.count += values.size();
+			res.sum += sum;
+			res.min = lo;
+			res.max = hi;
+		}
+
+#if defined(AGGREGATE_SSE2)
+		inline void summarize_sse2(summary& res, std::span<const int> values) noexcept
+		{
+			const int* data = values.data();
+			std::size_t i = 0;
+			__m128i sum = _mm_setzero_si128();
+			__m128i lo = _mm_set1_epi32(res.min);
+			__m128i hi = _mm_set1_epi32(res.max);
+			for (; i + 4 <= values.size(); i += 4) {
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				__m128i sign = _mm_srai_epi32(v, 31);		// sign extend to 64 bit lanes
+				sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+				sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+				__m128i lt = _mm_cmplt_epi32(v, lo);		// no _mm_min_epi32() before SSE4.1
+				lo = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, lo));
+				__m128i gt = _mm_cmpgt_epi32(v, hi);
+				hi = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, hi));
+			}
+			alignas(16) long long sums[2];
+			alignas(16) int mins[4];
+			alignas(16) int maxs[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+			_mm_store_si128(reinterpret_cast<__m128i*>(mins), lo);
+			_mm_store_si128(reinterpret_cast<__m128i*>(maxs), hi);
+			res.count += i;
+			res.sum += sums[0] + sums[1];
+			res.min = *std::min_element(std::begin(mins), std::end(mins));
+			res.max = *std::max_element(std::begin(maxs), std::end(maxs));
+			summarize_scalar(res, values.subspan(i));
+		}
+#endif
+
+#if defined(AGGREGATE_AVX2)
+		AGGREGATE_TARGET_AVX2 inline void summarize_avx2(summary& res, std::span<const int> values) noexcept
+		{
+			const int* data = values.data();
+			std::size_t i = 0;
+			__m256i sum = _mm256_setzero_si256();
+			__m256i lo = _mm256_set1_epi32(res.min);
+			__m256i hi = _mm256_set1_epi32(res.max);
+			for (; i + 8 <= values.size(); i += 8) {
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+				sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+				sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+				lo = _mm256_min_epi32(lo, v);
+				hi = _mm256_max_epi32(hi, v);
+			}
+			alignas(32) long long sums[4];
+			alignas(32) int mins[8];
+			alignas(32) int maxs[8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(sums), sum);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(mins), lo);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(maxs), hi);
+			res.count += i;
+			res.sum += sums[0] + sums[1] + sums[2] + sums[3];
+			res.min = *std::min_element(std::begin(mins), std::end(mins));
+			res.max = *std::max_element(std::begin(maxs), std::end(maxs));
+			summarize_scalar(res, values.subspan(i));
+		}
+#endif
+
+		inline void summarize_into(summary& res, std::span<const int> values, isa kind) noexcept
+		{
+			kind = usable(kind);
+#if defined(AGGREGATE_AVX2)
+			if (kind == isa::avx2) {
+				summarize_avx2(res, values);
+				return;
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			if (kind >= isa::sse2) {
+				summarize_sse2(res, values);
+				return;
+			}
+#endif
+			summarize_scalar(res, values);
+		}
+
+		inline void histogram_into(histogram& res, std::span<const int> values) noexcept
+		{
+			for (int val : values) {
+				auto bucket = static_cast<unsigned>(val);		// negative values become huge
+				if (bucket < buckets) {
+					++res.counts[bucket];
+				}
+				else {
+					++res.out_of_range;
+				}
+			}
+		}
+
+		// heap: min-heap of the (at most k) largest values so far
+		inline void push_top(std::vector<int>& heap, std::size_t k, int val)
+		{
+			if (heap.size() < k) {
+				heap.push_back(val);
+				std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+			}
+			else if (val > heap.front()) {
+				std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+				heap.back() = val;
+				std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+			}
+		}
+
+#if defined(AGGREGATE_AVX2)
+		// the blocks of 8 values from i on, returns where the blocks end
+		AGGREGATE_TARGET_AVX2 inline std::size_t top_k_avx2(std::vector<int>& heap, std::size_t k, std::span<const int> values, std::size_t i)
+		{
+			for (; i + 8 <= values.size(); i += 8) {
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + i));
+				__m256i gt = _mm256_cmpgt_epi32(v, _mm256_set1_epi32(heap.front()));
+				if (_mm256_movemask_epi8(gt) != 0) {
+					for (std::size_t j = i; j < i + 8; ++j) {
+						push_top(heap, k, values[j]);
+					}
+				}
+			}
+			return i;
+		}
+#endif
+
+		// once the heap is full, whole blocks not above its minimum are skipped with one comparison
+		inline void top_k_into(std::vector<int>& heap, std::size_t k, std::span<const int> values, isa kind)
+		{
+			if (k == 0) {
+				return;
+			}
+			kind = usable(kind);
+			std::size_t i = 0;
+			for (; i < values.size() && heap.size() < k; ++i) {
+				push_top(heap, k, values[i]);
+			}
+#if defined(AGGREGATE_AVX2)
+			if (kind == isa::avx2) {
+				i = top_k_avx2(heap, k, values, i);
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			if (kind >= isa::sse2) {
+				for (; i + 4 <= values.size(); i += 4) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values.data() + i));
+					__m128i gt = _mm_cmpgt_epi32(v, _mm_set1_epi32(heap.front()));
+					if (_mm_movemask_epi8(gt) != 0) {
+						for (std::size_t j = i; j < i + 4; ++j) {
+							push_top(heap, k, values[j]);
+						}
+					}
+				}
+			}
+#endif
+			for (; i < values.size(); ++i) {
+				push_top(heap, k, values[i]);
+			}
+		}
+
+		// the k largest values of a heap in descending order
+		inline std::vector<int> sorted_top(std::vector<int> heap)
+		{
+			std::sort_heap(heap.begin(), heap.end(), std::greater<>{});
+			return heap;
+		}
+
+		// func(first, last) for one chunk of [0, num) per thread, then combine(res, partial) in chunk order
+		template <typename Func, typename Combine>
+		auto reduce(std::size_t num, std::size_t min_chunk, unsigned threads, Func func, Combine combine)
+		{
+			if (threads == 0) {
+				threads = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+			std::size_t parts = std::clamp<std::size_t>(num / min_chunk, 1, threads);
+			using result = decltype(func(std::size_t{}, std::size_t{}));
+			std::vector<result> partial(parts);
+			parallel::parallel_for(parts, [&](std::size_t part) {
+				partial[part] = func(num * part / parts, num * (part + 1) / parts);
+			});
+			result res = std::move(partial[0]);
+			for (std::size_t part = 1; part < parts; ++part) {
+				combine(res, partial[part]);
+			}
+			return res;
+		}
+
+		inline constexpr std::size_t min_values_per_thread = 64 * 1024;
+		inline constexpr std::size_t min_customers_per_thread = 4096;
+	}
+
+	// sum, minimum and maximum
+	inline summary summarize(std::span<const int> values, isa kind = best_isa) noexcept
+	{
+		summary res;
+		detail::summarize_into(res, values, kind);
+		return res;
+	}
+	template <customer_range Customers>
+	summary summarize(const Customers& coll, isa kind = best_isa) noexcept
+	{
+		summary res;
+		for (std::size_t i = 0; i < std::size(coll); ++i) {
+			detail::summarize_into(res, detail::values_of(coll[i]), kind);
+		}
+		return res;
+	}
+
+	// counts of the values 0..buckets-1
+	inline histogram histogram_of(std::span<const int> values) noexcept
+	{
+		histogram res;
+		detail::histogram_into(res, values);
+		return res;
+	}
+	template <customer_range Customers>
+	histogram histogram_of(const Customers& coll) noexcept
+	{
+		histogram res;
+		for (std::size_t i = 0; i < std::size(coll); ++i) {
+			detail::histogram_into(res, detail::values_of(coll[i]));
+		}
+		return res;
+	}
+
+	// the k largest values in descending order
+	inline std::vector<int> top_k(std::span<const int> values, std::size_t k, isa kind = best_isa)
+	{
+		std::vector<int> heap;
+		heap.reserve(k);
+		detail::top_k_into(heap, k, values, kind);
+		return detail::sorted_top(std::move(heap));
+	}
+	template <customer_range Customers>
+	std::vector<int> top_k(const Customers& coll, std::size_t k, isa kind = best_isa)
+	{
+		std::vector<int> heap;
+		heap.reserve(k);
+		for (std::size_t i = 0; i < std::size(coll); ++i) {
+			detail::top_k_into(heap, k, detail::values_of(coll[i]), kind);
+		}
+		return detail::sorted_top(std::move(heap));
+	}
+
+	// the same with threads workers (0: one per hardware thread)
+	inline summary parallel_summarize(std::span<const int> values, unsigned threads = 0, isa kind = best_isa)
+	{
+		return detail::reduce(values.size(), detail::min_values_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				return summarize(values.subspan(first, last - first), kind);
+			},
+			[](summary& res, const summary& part) {
+				res += part;
+			});
+	}
+	template <customer_range Customers>
+	summary parallel_summarize(const Customers& coll, unsigned threads = 0, isa kind = best_isa)
+	{
+		return detail::reduce(std::size(coll), detail::min_customers_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				summary res;
+				for (std::size_t i = first; i < last; ++i) {
+					detail::summarize_into(res, detail::values_of(coll[i]), kind);
+				}
+				return res;
+			},
+			[](summary& res, const summary& part) {
+				res += part;
+			});
+	}
+
+	inline histogram parallel_histogram(std::span<const int> values, unsigned threads = 0)
+	{
+		return detail::reduce(values.size(), detail::min_values_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				return histogram_of(values.subspan(first, last - first));
+			},
+			[](histogram& res, const histogram& part) {
+				res += part;
+			});
+	}
+	template <customer_range Customers>
+	histogram parallel_histogram(const Customers& coll, unsigned threads = 0)
+	{
+		return detail::reduce(std::size(coll), detail::min_customers_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				histogram res;
+				for (std::size_t i = first; i < last; ++i) {
+					detail::histogram_into(res, detail::values_of(coll[i]));
+				}
+				return res;
+			},
+			[](histogram& res, const histogram& part) {
+				res += part;
+			});
+	}
+
+	inline std::vector<int> parallel_top_k(std::span<const int> values, std::size_t k, unsigned threads = 0, isa kind = best_isa)
+	{
+		std::vector<int> heap = detail::reduce(values.size(), detail::min_values_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				std::vector<int> part;
+				part.reserve(k);
+				detail::top_k_into(part, k, values.subspan(first, last - first), kind);
+				return part;
+			},
+			[&](std::vector<int>& res, const std::vector<int>& part) {
+				detail::top_k_into(res, k, part, isa::scalar);
+			});
+		return detail::sorted_top(std::move(heap));
+	}
+	template <customer_range Customers>
+	std::vector<int> parallel_top_k(const Customers& coll, std::size_t k, unsigned threads = 0, isa kind = best_isa)
+	{
+		std::vector<int> heap = detail::reduce(std::size(coll), detail::min_customers_per_thread, threads,
+			[&](std::size_t first, std::size_t last) {
+				std::vector<int> part;
+				part.reserve(k);
+				for (std::size_t i = first; i < last; ++i) {
+					detail::top_k_into(part, k, detail::values_of(coll[i]), kind);
+				}
+				return part;
+			},
+			[&](std::vector<int>& res, const std::vector<int>& part) {
+				detail::top_k_into(res, k, part, isa::scalar);
+			});
+		return detail::sorted_top(std::move(heap));
+	}
+}
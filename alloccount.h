@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+// Allocation accounting
+// Counts the calls of the global operator new together with the requested bytes
+// and the peak of the live bytes, process wide and per scoped region:
+//
+//		alloccount::scope s;
+//		coll.push_back(std::move(str));
+//		assert(s.current().count == 0);		// moving into reserved memory never allocates
+//
+// The replacement of the global operators is opt-in, as it makes every allocation pay
+// for the size header and the atomic counters: define ALLOCCOUNT_INSTALL for exactly one
+// translation unit, e.g. g++ -DALLOCCOUNT_INSTALL or msbuild /p:AllocCount=true.
+// Without it all counters stay zero and alloccount::installed() returns false; print
+// counts with alloccount::show() so that reports say "n/a" then:
+//
+//		std::cout << std::setw(8) << alloccount::show(s.current().count);
+namespace alloccount
+{
+	struct counters {
+		std::atomic<std::size_t>	count{ 0 };		// calls of operator new
+		std::atomic<std::size_t>	bytes{ 0 };		// bytes requested by them
+		std::atomic<std::size_t>	live{ 0 };		// bytes allocated but not released yet
+		std::atomic<std::size_t>	peak{ 0 };		// maximum of live since the innermost scope began
+		bool						installed{ false };
+	};
+
+	inline counters& global()
+	{
+		static counters cnt;	// constant initialized, so usable before main()
+		return cnt;
+	}
+
+	inline bool installed()
+	{
+		return global().installed;
+	}
+
+	struct stats {
+		std::size_t	count{ 0 };		// allocations
+		std::size_t	bytes{ 0 };		// bytes requested
+		std::size_t	peak{ 0 };		// peak of live bytes above the live bytes at the start
+	};
+
+	// record the allocations of all threads while the scope exists (scopes must nest)
+	class scope {
+	private:
+		std::size_t	m_count;
+		std::size_t	m_bytes;
+		std::size_t	m_live;
+		std::size_t	m_outer_peak;
+	public:
+		scope()
+		{
+			counters& cnt = global();
+			m_count = cnt.count.load(std::memory_order_relaxed);
+			m_bytes = cnt.bytes.load(std::memory_order_relaxed);
+			m_live = cnt.live.load(std::memory_order_relaxed);
+			m_outer_peak = cnt.peak.exchange(m_live, std::memory_order_relaxed);
+		}
+		~scope()
+		{
+			// hand the peak back to the enclosing scope
+			counters& cnt = global();
+			std::size_t inner = cnt.peak.load(std::memory_order_relaxed);
+			cnt.peak.store(inner > m_outer_peak ? inner : m_outer_peak, std::memory_order_relaxed);
+		}
+		scope(const scope&) = delete;
+		scope& operator= (const scope&) = delete;
+
+		// allocations since the scope began
+		stats current() const
+		{
+			counters& cnt = global();
+			alloccount::stats res;
+			res.count = cnt.count.load(std::memory_order_relaxed) - m_count;
+			res.bytes = cnt.bytes.load(std::memory_order_relaxed) - m_bytes;
+			std::size_t peak = cnt.peak.load(std::memory_order_relaxed);
+			res.peak = peak > m_live ? peak - m_live : 0;
+			return res;
+		}
+	};
+
+	// a count for reports (see show())
+	template <typename T>
+	struct shown {
+		T		value;
+		bool	json;
+	};
+
+	// value as is if the operators are replaced, otherwise "n/a" (or null for JSON)
+	template <typename T>
+	shown<T> show(T value, bool json = false)
+	{
+		return shown<T>{ value, json };
+	}
+
+	template <typename T>
+	std::ostream& operator<< (std::ostream& strm, const shown<T>& s)
+	{
+		if (installed()) {
+			return strm << s.value;
+		}
+		return strm << (s.json ? "null" : "n/a");
+	}
+
+	namespace detail
+	{
+		// every block carries its size in front, so unsized delete can account for it
+		constexpr std::size_t header_size = alignof(std::max_align_t) < sizeof(std::size_t)
+			? sizeof(std::size_t) : alignof(std::max_align_t);
+
+		inline void* allocate(std::size_t size) noexcept
+		{
+			void* raw = std::malloc(size + header_size);
+			if (!raw) {
+				return nullptr;
+			}
+			*static_cast<std::size_t*>(raw) = size;
+
+			counters& cnt = global();
+			cnt.count.fetch_add(1, std::memory_order_relaxed);
+			cnt.bytes.fetch_add(size, std::memory_order_relaxed);
+			std::size_t live = cnt.live.fetch_add(size, std::memory_order_relaxed) + size;
+			std::size_t peak = cnt.peak.load(std::memory_order_relaxed);
+			while (live > peak && !cnt.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+			}
+			return static_cast<char*>(raw) + header_size;
+		}
+
+		inline void deallocate(void* p) noexcept
+		{
+			if (!p) {
+				return;
+			}
+			void* raw = static_cast<char*>(p) - header_size;
+			global().live.fetch_sub(*static_cast<std::size_t*>(raw), std::memory_order_relaxed);
+			std::free(raw);
+		}
+
+		inline void* allocate_or_throw(std::size_t size)
+		{
+			for (;;) {
+				if (void* p = allocate(size ? size : 1)) {
+					return p;
+				}
+				std::new_handler handler = std::get_new_handler();
+				if (!handler) {
+					throw std::bad_alloc{};
+				}
+				handler();
+			}
+		}
+
+		struct install {
+			install() noexcept
+			{
+				global().installed = true;
+			}
+		};
+	}
+}
+
+#ifdef ALLOCCOUNT_INSTALL
+
+// over-aligned new/delete are not replaced, their default versions do not use these
+static alloccount::detail::install alloccount_install;
+
+void* operator new(std::size_t size)
+{
+	return alloccount::detail::allocate_or_throw(size);
+}
+void* operator new[](std::size_t size)
+{
+	return alloccount::detail::allocate_or_throw(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return alloccount::detail::allocate_or_throw(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return alloccount::detail::allocate_or_throw(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+void operator delete(void* p) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+void operator delete[](void* p) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	alloccount::detail::deallocate(p);
+}
+
+#endif // ALLOCCOUNT_INSTALL
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "alloccount.h"
+#include "perfcount.h"
+
+// Statistical micro-benchmark engine
+// Grown out of chapter_4::sec_4_3_4::measure(): instead of summing steady_clock deltas
+// and printing an average, the engine calibrates the number of iterations per sample,
+// collects many samples, rejects outliers and reports median/p90/p99 and stddev
+// (as text or as one JSON object per benchmark).
+// With config::perf the measured regions (see stopwatch) also count hardware events.
+// Sections that report a benchmark themselves use measure() with limited() settings,
+// which also counts the allocations of one more iteration:
+//
+//		benchmark::measured res = benchmark::measure("replay", benchmark::limited(10, num),
+//			[&] { moved = names; },					// untimed setup of every iteration
+//			[&] { apply(p, names, moved); });
+//		std::cout << res.time.median / num << " ns, " << alloccount::show(res.allocs) << " allocs\n";
+namespace benchmark
+{
+	// force the compiler to assume value is read (so computing it cannot be optimized away)
+	template <typename T>
+	inline void do_not_optimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*)) {
+			asm volatile("" : : "r,m"(value) : "memory");
+		}
+		else {
+			asm volatile("" : : "m"(value) : "memory");
+		}
+#else
+		static const volatile void* sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#endif
+	}
+
+	// force the compiler to assume all memory is read and written
+	inline void clobber_memory()
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : : "memory");
+#else
+		_ReadWriteBarrier();
+#endif
+	}
+
+	struct config {
+		std::chrono::nanoseconds	min_sample_time{ std::chrono::milliseconds{ 5 } };	// calibration target per sample
+		std::size_t					max_iterations{ std::size_t{ 1 } << 30 };			// calibration limit per sample
+		int							warmup_samples{ 2 };		// samples taken and dropped before measuring
+		int							samples{ 30 };				// samples taken for the statistics
+		double						outlier_fence{ 3.0 };		// reject samples outside [q1 - f*iqr, q3 + f*iqr]
+		bool						json{ false };				// report as JSON instead of text
+		bool						print{ true };				// print the result (off if the caller reports itself)
+		bool						perf{ false };				// count hardware events in the measured regions
+		double						items{ 1 };					// items (e.g. elements) processed per iteration
+	};
+
+	// process wide defaults (set from the command line of the section runner)
+	inline config& settings()
+	{
+		static config cfg;
+		return cfg;
+	}
+
+	// all times are nanoseconds per iteration
+	struct stats {
+		std::string	name;
+		std::size_t	iterations{ 0 };	// iterations per sample
+		std::size_t	samples{ 0 };		// samples used for the statistics
+		std::size_t	outliers{ 0 };		// samples rejected
+		double		mean{ 0 };
+		double		median{ 0 };
+		double		p90{ 0 };
+		double		p99{ 0 };
+		double		stddev{ 0 };
+		double		min{ 0 };
+		double		max{ 0 };
+		double		items{ 1 };			// items per iteration
+		perfcount::sample perf{};		// hardware events per item (mean over all samples)
+	};
+
+	namespace detail
+	{
+		// hardware counters of the benchmark taking samples on this thread (null if not counting)
+		inline perfcount::counters*& active_counters()
+		{
+			thread_local perfcount::counters* active = nullptr;
+			return active;
+		}
+
+		// hardware events counted by the stopwatches since the samples began
+		inline perfcount::sample& counted_events()
+		{
+			thread_local perfcount::sample events;
+			return events;
+		}
+	}
+
+	// Times the measured regions of a sample (start()/stop() may be called repeatedly)
+	// and counts hardware events in them while a benchmark with config::perf samples.
+	class stopwatch {
+	private:
+		std::chrono::nanoseconds				m_elapsed{ 0 };
+		std::chrono::steady_clock::time_point	m_t0;
+	public:
+		void start()
+		{
+			if (perfcount::counters* cnt = detail::active_counters()) {
+				cnt->start();
+			}
+			m_t0 = std::chrono::steady_clock::now();
+		}
+		void stop()
+		{
+			auto t1 = std::chrono::steady_clock::now();
+			if (perfcount::counters* cnt = detail::active_counters()) {
+				detail::counted_events() += cnt->stop();
+			}
+			m_elapsed += t1 - m_t0;
+		}
+		std::chrono::nanoseconds elapsed() const
+		{
+			return m_elapsed;
+		}
+	};
+
+	// percentile (0..1) of sorted values with linear interpolation
+	inline double percentile(const std::vector<double>& sorted, double p)
+	{
+		if (sorted.empty()) {
+			return 0;
+		}
+		double pos = p * static_cast<double>(sorted.size() - 1);
+		std::size_t lo = static_cast<std::size_t>(pos);
+		std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+		return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+	}
+
+	// compute the statistics of samples after rejecting outliers
+	inline stats analyze(std::string name, std::size_t iterations, std::vector<double> samples, double fence)
+	{
+		stats res{ std::move(name), iterations };
+		std::sort(samples.begin(), samples.end());
+
+		double q1 = percentile(samples, 0.25);
+		double q3 = percentile(samples, 0.75);
+		double lo = q1 - fence * (q3 - q1);
+		double hi = q3 + fence * (q3 - q1);
+		std::vector<double> kept;
+		kept.reserve(samples.size());
+		std::copy_if(samples.begin(), samples.end(), std::back_inserter(kept),
+					 [&](double s) { return s >= lo && s <= hi; });
+
+		res.samples = kept.size();
+		res.outliers = samples.size() - kept.size();
+		if (kept.empty()) {
+			return res;
+		}
+
+		double sum = 0;
+		for (double s : kept) {
+			sum += s;
+		}
+		res.mean = sum / static_cast<double>(kept.size());
+		double sq = 0;
+		for (double s : kept) {
+			sq += (s - res.mean) * (s - res.mean);
+		}
+		res.stddev = kept.size() > 1 ? std::sqrt(sq / static_cast<double>(kept.size() - 1)) : 0.0;
+		res.median = percentile(kept, 0.5);
+		res.p90 = percentile(kept, 0.9);
+		res.p99 = percentile(kept, 0.99);
+		res.min = kept.front();
+		res.max = kept.back();
+		return res;
+	}
+
+	inline void print_json_string(std::ostream& strm, const std::string& s)
+	{
+		strm << '"';
+		for (char c : s) {
+			if (c == '"' || c == '\\') {
+				strm << '\\';
+			}
+			strm << c;
+		}
+		strm << '"';
+	}
+
+	inline constexpr const char* perf_keys[perfcount::num_counters]{
+		"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+	};
+
+	inline void print(std::ostream& strm, const stats& res, bool json)
+	{
+		if (json) {
+			strm << "{\"name\":";
+			print_json_string(strm, res.name);
+			strm << ",\"iterations\":" << res.iterations
+				 << ",\"samples\":" << res.samples
+				 << ",\"outliers\":" << res.outliers
+				 << std::setprecision(6)
+				 << ",\"mean_ns\":" << res.mean
+				 << ",\"median_ns\":" << res.median
+				 << ",\"p90_ns\":" << res.p90
+				 << ",\"p99_ns\":" << res.p99
+				 << ",\"stddev_ns\":" << res.stddev
+				 << ",\"min_ns\":" << res.min
+				 << ",\"max_ns\":" << res.max
+				 << ",\"items\":" << res.items;
+			if (res.perf.valid[perfcount::cycles] && res.perf.valid[perfcount::instructions]) {
+				strm << ",\"ipc\":" << res.perf.ipc();
+			}
+			for (std::size_t i = perfcount::l1d_misses; i < perfcount::num_counters; ++i) {
+				if (res.perf.valid[i]) {
+					strm << ",\"" << perf_keys[i] << "_per_item\":" << res.perf.values[i];
+				}
+			}
+			strm << "}\n";
+			return;
+		}
+		strm << res.name << ": " << std::fixed << std::setprecision(1)
+			 << "median " << res.median << "ns"
+			 << ", p90 " << res.p90 << "ns"
+			 << ", p99 " << res.p99 << "ns"
+			 << ", stddev " << res.stddev << "ns"
+			 << " (" << res.samples << " samples of " << res.iterations << " iterations, "
+			 << res.outliers << " outliers)\n";
+		if (res.perf.valid[perfcount::cycles] && res.perf.valid[perfcount::instructions]) {
+			strm << "  IPC " << std::setprecision(2) << res.perf.ipc();
+			const char* sep = (res.items == 1 ? ", per iteration:" : ", per item:");
+			for (std::size_t i = perfcount::l1d_misses; i < perfcount::num_counters; ++i) {
+				if (res.perf.valid[i]) {
+					strm << sep << ' ' << perfcount::counter_names[i] << ' ' << std::setprecision(3) << res.perf.values[i];
+					sep = ",";
+				}
+			}
+			strm << '\n';
+		}
+		strm << std::defaultfloat;
+	}
+
+	// Measure func(iters), which runs iters iterations and returns the time they took.
+	// Use this form to keep per iteration setup out of the measurement (as measure() does).
+	template <typename Func>
+	stats run_manual(std::string name, Func&& func, const config& cfg = settings())
+	{
+		// calibrate: grow the iterations until a sample takes at least min_sample_time
+		std::size_t iters = 1;
+		while (iters < cfg.max_iterations) {
+			std::chrono::nanoseconds dur = func(iters);
+			if (dur >= cfg.min_sample_time) {
+				break;
+			}
+			// aim a bit above the target, but at most grow tenfold per step
+			double factor = dur.count() > 0
+				? 1.4 * static_cast<double>(cfg.min_sample_time.count()) / static_cast<double>(dur.count())
+				: 10.0;
+			std::size_t next = static_cast<std::size_t>(static_cast<double>(iters) * std::min(factor, 10.0));
+			iters = std::min(std::max(next, iters + 1), cfg.max_iterations);
+		}
+
+		for (int i = 0; i < cfg.warmup_samples; ++i) {
+			func(iters);
+		}
+
+		// count hardware events only while taking the samples
+		std::unique_ptr<perfcount::counters> cnt;
+		if (cfg.perf) {
+			cnt = std::make_unique<perfcount::counters>();
+			if (!cnt->available()) {
+				static bool warned = false;
+				if (!warned) {
+					std::cerr << "hardware performance counters are not available\n";
+					warned = true;
+				}
+				cnt.reset();
+			}
+		}
+		detail::counted_events() = perfcount::sample{};
+		detail::active_counters() = cnt.get();
+
+		std::vector<double> samples;
+		samples.reserve(static_cast<std::size_t>(cfg.samples));
+		for (int i = 0; i < cfg.samples; ++i) {
+			std::chrono::nanoseconds dur = func(iters);
+			samples.push_back(static_cast<double>(dur.count()) / static_cast<double>(iters));
+		}
+		detail::active_counters() = nullptr;
+
+		stats res = analyze(std::move(name), iters, std::move(samples), cfg.outlier_fence);
+		res.items = cfg.items;
+		res.perf = detail::counted_events();
+		double per_item = static_cast<double>(iters) * static_cast<double>(cfg.samples) * cfg.items;
+		for (double& value : res.perf.values) {
+			value /= per_item;
+		}
+		if (cfg.print) {
+			print(std::cout, res, cfg.json);
+		}
+		return res;
+	}
+
+	// measure func(), which performs one iteration
+	template <typename Func>
+	stats run(std::string name, Func&& func, const config& cfg = settings())
+	{
+		return run_manual(std::move(name), [&func](std::size_t iters) {
+			stopwatch watch;
+			watch.start();
+			for (std::size_t i = 0; i < iters; ++i) {
+				func();
+				clobber_memory();
+			}
+			watch.stop();
+			return watch.elapsed();
+		}, cfg);
+	}
+
+	// settings() with at most max_samples samples (for slow iterations) of items per
+	// iteration, not printed (the caller reports the result)
+	inline config limited(int max_samples, double items = 1)
+	{
+		config cfg = settings();
+		cfg.samples = std::min(cfg.samples, max_samples);
+		cfg.items = items;
+		cfg.print = false;
+		return cfg;
+	}
+
+	struct measured {
+		stats		time;			// per iteration
+		std::size_t	allocs{ 0 };	// of one iteration (print with alloccount::show())
+	};
+
+	// measure func() as run() does, then count the allocations of one more call
+	template <typename Func>
+	measured measure(std::string name, const config& cfg, Func&& func)
+	{
+		measured res{ run(std::move(name), func, cfg) };
+		alloccount::scope allocs;
+		func();
+		res.allocs = allocs.current().count;
+		return res;
+	}
+
+	// measure work() after an untimed setup() in every iteration, then count the
+	// allocations of one more work() (after setup())
+	template <typename Setup, typename Work>
+	measured measure(std::string name, const config& cfg, Setup&& setup, Work&& work)
+	{
+		measured res{ run_manual(std::move(name), [&](std::size_t iters) {
+			stopwatch watch;
+			for (std::size_t i = 0; i < iters; ++i) {
+				setup();
+				watch.start();
+				work();
+				clobber_memory();
+				watch.stop();
+			}
+			return watch.elapsed();
+		}, cfg) };
+		setup();
+		alloccount::scope allocs;
+		work();
+		res.allocs = allocs.current().count;
+		return res;
+	}
+}
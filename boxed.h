@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "relocate.h"
+
+// Heap-indirected value wrapper
+// Moving a class with a large member like std::array<double, 10000> (chapter_4::sec_4_3_4::Person2)
+// copies the whole array, std::array has no pointer to steal. boxed<T> keeps the T on the
+// heap but behaves like a T member otherwise: copying copies the value (deep), moving
+// steals the pointer (O(1), noexcept):
+//
+//		class Telemetry {
+//			std::string								m_source;
+//			boxed::boxed<std::array<double, 1000>>	m_samples;		// sizeof is one pointer
+//		};
+//
+// With InlineMax > 0 a T of at most InlineMax bytes stays inside the object (no heap
+// allocation, moves move the T), so one template works for small and large payloads:
+//
+//		boxed::boxed<std::array<double, N>, 256> samples;		// on the heap only if N > 32
+//
+// Like std::indirect (C++26), a boxed moved from is empty (valueless_after_move()):
+// it may only be assigned to or destroyed.
+namespace boxed
+{
+	template <typename T, std::size_t InlineMax = 0>
+	class boxed {
+	public:
+		static constexpr bool is_inline = sizeof(T) <= InlineMax;
+
+	private:
+		std::conditional_t<is_inline, T, T*> m_data;
+
+	public:
+		// a heap block is moved by copying the pointer
+		using trivially_relocatable = std::bool_constant<!is_inline || relocate::is_trivially_relocatable_v<T>>;
+
+		boxed()
+			requires std::is_default_constructible_v<T>
+			: boxed(std::in_place)
+		{}
+		boxed(const T& val)
+			: boxed(std::in_place, val)
+		{}
+		boxed(T&& val)
+			: boxed(std::in_place, std::move(val))
+		{}
+		template <typename... Args>
+		explicit boxed(std::in_place_t, Args&&... args)
+			requires (is_inline)
+			: m_data(std::forward<Args>(args)...)
+		{}
+		template <typename... Args>
+		explicit boxed(std::in_place_t, Args&&... args)
+			requires (!is_inline)
+			: m_data{ new T(std::forward<Args>(args)...) }
+		{}
+
+		boxed(const boxed& b)
+			requires (is_inline)
+			= default;
+		boxed(const boxed& b)
+			requires (!is_inline)
+			: m_data{ b.m_data ? new T(*b.m_data) : nullptr }
+		{}
+		boxed(boxed&& b)
+			requires (is_inline)
+			= default;
+		boxed(boxed&& b) noexcept
+			requires (!is_inline)
+			: m_data{ std::exchange(b.m_data, nullptr) }
+		{}
+
+		boxed& operator= (const boxed& b)
+			requires (is_inline)
+			= default;
+		boxed& operator= (const boxed& b)
+			requires (!is_inline)
+		{
+			if (m_data && b.m_data) {
+				*m_data = *b.m_data;		// reuse the block
+			}
+			else if (this != &b) {
+				boxed tmp{ b };
+				swap(*this, tmp);
+			}
+			return *this;
+		}
+		boxed& operator= (boxed&& b)
+			requires (is_inline)
+			= default;
+		boxed& operator= (boxed&& b) noexcept
+			requires (!is_inline)
+		{
+			if (this != &b) {
+				delete m_data;
+				m_data = std::exchange(b.m_data, nullptr);
+			}
+			return *this;
+		}
+
+		~boxed()
+			requires (is_inline)
+			= default;
+		~boxed()
+			requires (!is_inline)
+		{
+			delete m_data;
+		}
+
+		bool valueless_after_move() const noexcept
+		{
+			if constexpr (is_inline) {
+				return false;
+			}
+			else {
+				return m_data == nullptr;
+			}
+		}
+
+		T& operator* () noexcept
+		{
+			assert(!valueless_after_move());
+			if constexpr (is_inline) {
+				return m_data;
+			}
+			else {
+				return *m_data;
+			}
+		}
+		const T& operator* () const noexcept
+		{
+			assert(!valueless_after_move());
+			if constexpr (is_inline) {
+				return m_data;
+			}
+			else {
+				return *m_data;
+			}
+		}
+		T* operator-> () noexcept
+		{
+			return &**this;
+		}
+		const T* operator-> () const noexcept
+		{
+			return &**this;
+		}
+
+		friend void swap(boxed& a, boxed& b) noexcept(!is_inline || std::is_nothrow_swappable_v<T>)
+		{
+			using std::swap;
+			swap(a.m_data, b.m_data);
+		}
+
+		// compares the values
+		friend bool operator== (const boxed& a, const boxed& b)
+		{
+			return *a == *b;
+		}
+	};
+}
@@ -201,7 +201,7 @@ namespace chapter_12
 		{
 			auto f = [](auto f, auto&&... args) -> decltype(auto)
 			{
-				decltype(auto) ret{ f(std::forward<Args>(args)...) };
+				decltype(auto) ret{ f(std::forward<decltype(args)>(args)...) };
 				// ...
 				if constexpr (std::is_rvalue_reference_v<decltype(ret)>) {
 					return std::move(ret);	// move xvalue returned by f() to caller
@@ -220,7 +220,7 @@ namespace chapter_12
 		{
 			auto f = [](auto f, auto&&... args) -> decltype(auto)
 			{
-				decltype(auto) ret{ f(std::forward<Args>(args)...) };
+				decltype(auto) ret{ f(std::forward<decltype(args)>(args)...) };
 				// ...
 				if constexpr (std::is_rvalue_reference_v<decltype(ret)>) {
 					return std::move(ret);	// move xvalue returned by f() to caller
@@ -1,8 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <utility>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include "alloccount.h"
+#include "benchmark.h"
+#include "linereader.h"
+#include "stringpool.h"
 
 namespace chapter_2
 {
@@ -149,6 +161,14 @@ namespace chapter_2
 			}
 		}
 
+		// the same without an allocation per row: map stdin (or read it into one buffer)
+		// and view the rows in place
+		void run2()
+		{
+			linereader::lines all_rows = linereader::lines::from_stdin();
+			benchmark::do_not_optimize(all_rows.size());
+		}
+
 		// swap using move semantics
 		template <typename T>
 		void swap(T& a, T& b)
@@ -159,6 +179,152 @@ namespace chapter_2
 		}
 	}
 
+	// line ingestion: getline() and move vs. views into a mapped file vs. parallel splitting
+	namespace sec_2_3_2b
+	{
+		// write num rows, most of them too long for the SSO buffer
+		void make_file(const std::string& path, std::size_t num)
+		{
+			std::ofstream out{ path, std::ios::binary };
+			for (std::size_t i = 0; i < num; ++i) {
+				out << "row " << i << ' ' << std::string(i % 64, 'x') << '\n';
+			}
+		}
+
+		template <typename Func>
+		void measure(const std::string& what, Func&& load, std::size_t num)
+		{
+			benchmark::config cfg = benchmark::limited(10, static_cast<double>(num));
+			cfg.print = true;
+			benchmark::measured res = benchmark::measure(what, cfg, load);
+			std::cout << "  allocations per load: " << alloccount::show(res.allocs) << '\n';
+		}
+
+		void run()
+		{
+			const std::size_t num = 200000;
+			std::string path = (std::filesystem::temp_directory_path() / "sec_2_3_2b.txt").string();
+			make_file(path, num);
+
+			measure("getline() + push_back(std::move(row))", [&] {
+				std::ifstream in{ path };
+				std::vector<std::string> all_rows;
+				std::string row;
+				while (std::getline(in, row)) {
+					all_rows.push_back(std::move(row));
+				}
+				benchmark::do_not_optimize(all_rows.size());
+			}, num);
+			measure("mapped string_views", [&] {
+				linereader::lines all_rows = linereader::lines::from_file(path);
+				benchmark::do_not_optimize(all_rows.size());
+			}, num);
+			measure("mapped + materialize()", [&] {
+				std::vector<std::string> all_rows = linereader::lines::from_file(path).materialize();
+				benchmark::do_not_optimize(all_rows.size());
+			}, num);
+			unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+			measure("mapped + split_parallel() with " + std::to_string(threads) + " threads", [&] {
+				linereader::buffer buf = linereader::buffer::map(path);
+				std::vector<std::string> all_rows = linereader::split_parallel(buf.view(), threads);
+				benchmark::do_not_optimize(all_rows.size());
+			}, num);
+
+			std::filesystem::remove(path);
+		}
+	}
+
+	// long running ingest loop: rows are read, moved into a batch, processed and dropped
+	namespace sec_2_3_2c
+	{
+		const std::size_t batch_size = 1000;
+
+		std::string make_input(std::size_t num)
+		{
+			std::string text;
+			for (std::size_t i = 0; i < num; ++i) {
+				text += "row " + std::to_string(i) + ' ' + std::string(i % 64, 'x') + '\n';
+			}
+			return text;
+		}
+
+		void process(const std::vector<std::string>& batch)
+		{
+			benchmark::do_not_optimize(batch.size());
+		}
+
+		std::size_t ingest(std::istream& strm)
+		{
+			std::vector<std::string> batch;
+			batch.reserve(batch_size);
+			std::size_t num = 0;
+			std::string row;
+			while (std::getline(strm, row)) {	// every row starts without a buffer
+				batch.push_back(std::move(row));
+				if (batch.size() == batch_size) {
+					process(batch);
+					num += batch.size();
+					batch.clear();
+				}
+			}
+			process(batch);
+			return num + batch.size();
+		}
+
+		std::size_t ingest(std::istream& strm, stringpool::pool& pool)
+		{
+			std::vector<std::string> batch;
+			batch.reserve(batch_size);
+			std::size_t num = 0;
+			std::string row = pool.acquire();
+			while (std::getline(strm, row)) {	// reuses the buffer of a consumed row
+				batch.push_back(std::move(row));
+				row = pool.acquire();
+				if (batch.size() == batch_size) {
+					process(batch);
+					num += batch.size();
+					pool.release(batch);
+				}
+			}
+			process(batch);
+			num += batch.size();
+			pool.release(batch);
+			pool.release(std::move(row));
+			return num;
+		}
+
+		void run()
+		{
+			const std::string text = make_input(100000);
+
+			{
+				std::istringstream strm{ text };
+				alloccount::scope allocs;
+				std::size_t num = ingest(strm);
+				std::cout << "getline() + move:    " << num << " rows, "
+						  << alloccount::show(allocs.current().count) << " allocations\n";
+			}
+
+			stringpool::pool pool{ 128, 2 * batch_size };
+			{
+				std::istringstream strm{ text };		// first pass fills the pool
+				ingest(strm, pool);
+			}
+			pool.reset_stats();
+			{
+				std::istringstream strm{ text };
+				alloccount::scope allocs;
+				std::size_t num = ingest(strm, pool);
+				const stringpool::stats& st = pool.stats();
+				std::cout << "with string pool:    " << num << " rows, "
+						  << alloccount::show(allocs.current().count) << " allocations (the batch vector)\n"
+						  << "  pool hits " << st.hits << ", misses " << st.misses
+						  << ", hit rate " << std::fixed << std::setprecision(1) << 100 * st.hit_rate() << '%'
+						  << std::defaultfloat << ", recycled " << st.recycled << ", discarded " << st.discarded << '\n';
+			}
+		}
+	}
+
 	namespace sec_2_3_3
 	{
 		struct X {
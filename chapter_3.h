@@ -6,42 +6,91 @@
 #include <string>
 #include <cassert>
 #include <random>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "aggregate.h"
+#include "alloccount.h"
+#include "benchmark.h"
+#include "customerfmt.h"
+#include "customergen.h"
+#include "customertable.h"
+#include "keysort.h"
+#include "movecheck.h"
+#include "nameindex.h"
+#include "relocate.h"
+#include "smallvector.h"
+#include "snapshot.h"
+#include "smfcount.h"
 
 namespace chapter_3
 {
 	namespace sec_3_1
 	{
-		class Customer {
+		// Values is the container of the values (e.g. a smallvector::small_vector<int, 10>)
+		template <typename Values>
+		class BasicCustomer {
 		private:
 			std::string			m_name;		// name of the customer
-			std::vector<int>	m_values;	// some values of the customer
+			Values				m_values;	// some values of the customer
 		public:
-			Customer(const std::string& n)
+			// relocatable by copying its bytes if its members are (see relocate::swap)
+			using trivially_relocatable = relocate::all_trivially_relocatable<std::string, Values>;
+
+			BasicCustomer(const std::string& n)
 				: m_name(n)
 			{
 				assert(!m_name.empty());
 			}
 
+			// take over name and values (e.g. when loading a snapshot, see snapshot.h)
+			BasicCustomer(std::string n, Values vals)
+				: m_name(std::move(n)), m_values(std::move(vals))
+			{
+				assert(!m_name.empty());
+			}
+
 			std::string get_name() const
 			{
 				return m_name;
 			}
 
+			const Values& get_values() const
+			{
+				return m_values;
+			}
+
 			void add_value(int val)
 			{
 				m_values.push_back(val);
 			}
 
-			friend std::ostream& operator<< (std::ostream& strm, const Customer& cust)
+			// formats with std::to_chars() into a small buffer on the stack (see customerfmt.h)
+			friend std::ostream& operator<< (std::ostream& strm, const BasicCustomer& cust)
 			{
-				strm << '[' << cust.m_name << ": ";
-				for (int val : cust.m_values) {
-					strm << val << ' ';
-				}
-				strm << ']';
+				customerfmt::basic_writer<256> out{ strm };
+				out << cust;
 				return strm;
 			}
+
+			template <std::size_t Capacity>
+			friend customerfmt::basic_writer<Capacity>& operator<< (customerfmt::basic_writer<Capacity>& out, const BasicCustomer& cust)
+			{
+				return out.customer(cust.m_name, { std::data(cust.m_values), std::size(cust.m_values) });
+			}
 		};
+
+		using Customer = BasicCustomer<std::vector<int>>;
 		
 		void run()
 		{
@@ -97,9 +146,641 @@ namespace chapter_3
 		}
 	}
 
+	// a million customers as objects vs. in columns (see customertable.h)
+	namespace sec_3_1b
+	{
+		const std::size_t num = 1'000'000;
+
+		std::string name_of(std::size_t i)
+		{
+			return "my test customer " + std::to_string(i);		// too long for SSO
+		}
+
+		struct build_stats {
+			double		ms;
+			std::size_t	allocs;
+			std::size_t	kib;		// heap memory in use afterwards
+		};
+
+		template <typename Build>
+		auto build(Build&& build_func, build_stats& res)
+		{
+			alloccount::scope allocs;
+			auto t0 = std::chrono::steady_clock::now();
+			auto coll = build_func();
+			auto t1 = std::chrono::steady_clock::now();
+			res.ms = std::chrono::duration<double, std::milli>{ t1 - t0 }.count();
+			res.allocs = allocs.current().count;
+			res.kib = allocs.current().peak / 1024;
+			return coll;
+		}
+
+		void run()
+		{
+			build_stats objects_stats{};
+			std::vector<sec_3_1::Customer> customers = build([] {
+				std::vector<sec_3_1::Customer> coll;
+				coll.reserve(num);
+				for (std::size_t i = 0; i < num; ++i) {
+					sec_3_1::Customer cust{ name_of(i) };
+					for (int val : { 0, 8, 15 }) {
+						cust.add_value(val + static_cast<int>(i % 100));
+					}
+					coll.push_back(std::move(cust));
+				}
+				return coll;
+			}, objects_stats);
+
+			build_stats table_stats{};
+			customertable::CustomerTable table = build([] {
+				customertable::CustomerTable tab;
+				tab.reserve(num, num * name_of(num).size(), 3 * num);
+				for (std::size_t i = 0; i < num; ++i) {
+					std::size_t idx = tab.add(name_of(i));
+					for (int val : { 0, 8, 15 }) {
+						tab.add_value(idx, val + static_cast<int>(i % 100));
+					}
+				}
+				return tab;
+			}, table_stats);
+
+			std::cout << std::fixed << std::setprecision(1)
+					  << "build " << num << " customers:\n"
+					  << "  std::vector<Customer>: " << objects_stats.ms << "ms, "
+					  << alloccount::show(objects_stats.allocs) << " allocations, " << alloccount::show(objects_stats.kib) << " KiB peak\n"
+					  << "  CustomerTable:         " << table_stats.ms << "ms, "
+					  << alloccount::show(table_stats.allocs) << " allocations, " << alloccount::show(table_stats.kib) << " KiB peak ("
+					  << table.memory_usage() / 1024 << " KiB in columns)\n"
+					  << std::defaultfloat;
+
+			benchmark::config cfg = benchmark::limited(15, static_cast<double>(num));
+			cfg.print = true;
+			benchmark::run("scan values of std::vector<Customer>", [&] {
+				long long sum = 0;
+				for (const sec_3_1::Customer& cust : customers) {
+					for (int val : cust.get_values()) {
+						sum += val;
+					}
+				}
+				benchmark::do_not_optimize(sum);
+			}, cfg);
+			benchmark::run("scan values of CustomerTable", [&] {
+				long long sum = 0;
+				for (int val : table.all_values()) {
+					sum += val;
+				}
+				benchmark::do_not_optimize(sum);
+			}, cfg);
+			benchmark::run("scan name lengths of std::vector<Customer>", [&] {
+				std::size_t len = 0;
+				for (const sec_3_1::Customer& cust : customers) {
+					len += cust.get_name().size();		// get_name() returns a copy
+				}
+				benchmark::do_not_optimize(len);
+			}, cfg);
+			benchmark::run("scan name lengths of CustomerTable", [&] {
+				std::size_t len = 0;
+				for (std::size_t i = 0; i < table.size(); ++i) {
+					len += table[i].get_name().size();
+				}
+				benchmark::do_not_optimize(len);
+			}, cfg);
+
+			std::cout << "first customer: " << customers.front() << " / " << table[0] << '\n';
+		}
+	}
+
+	// the values of a customer inline (see smallvector.h) vs. in a std::vector<int>
+	namespace sec_3_1c
+	{
+		const std::size_t num = 100'000;
+
+		// num customers with 10 values each as create_customer() makes them
+		// (with names short enough for SSO, so only the values allocate)
+		template <typename C>
+		std::vector<C> create_customers()
+		{
+			std::vector<C> coll;
+			coll.reserve(num);
+			for (std::size_t i = 0; i < num; ++i) {
+				C cust{ "c" + std::to_string(i) };
+				for (int v = 0; v < 10; ++v) {
+					cust.add_value(static_cast<int>(i) + v);
+				}
+				coll.push_back(std::move(cust));
+			}
+			return coll;
+		}
+
+		template <typename C>
+		void measure(const char* type)
+		{
+			benchmark::config cfg = benchmark::limited(10, static_cast<double>(num));
+
+			std::vector<C> coll;
+			benchmark::measured construct = benchmark::measure(type, cfg, [&] {
+				coll = std::vector<C>{};		// destroy the previous customers untimed
+			}, [&] {
+				coll = create_customers<C>();
+			});
+
+			std::vector<C> dest;
+			benchmark::measured move = benchmark::measure(type, cfg, [&] {
+				dest = std::vector<C>{};		// free the previous iteration first, as locals would
+				coll = std::vector<C>{};
+				coll = create_customers<C>();
+				dest.reserve(coll.size());
+			}, [&] {
+				for (C& cust : coll) {
+					dest.push_back(std::move(cust));
+				}
+			});
+
+			coll = create_customers<C>();
+			benchmark::measured scan = benchmark::measure(type, cfg, [&] {
+				long long sum = 0;
+				for (const C& cust : coll) {
+					for (int val : cust.get_values()) {
+						sum += val;
+					}
+				}
+				benchmark::do_not_optimize(sum);
+			});
+
+			double per_cust = static_cast<double>(num);
+			std::cout << std::left << std::setw(24) << type << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(8) << sizeof(C)
+					  << std::setw(14) << construct.time.median / per_cust
+					  << std::setw(14) << alloccount::show(static_cast<double>(construct.allocs) / per_cust)
+					  << std::setw(10) << move.time.median / per_cust
+					  << std::setw(10) << scan.time.median / per_cust << '\n'
+					  << std::defaultfloat;
+		}
+
+		void run()
+		{
+			std::cout << std::left << std::setw(24) << "values" << std::right
+					  << std::setw(8) << "sizeof"
+					  << std::setw(14) << "construct ns"
+					  << std::setw(14) << "allocs/cust"
+					  << std::setw(10) << "move ns"
+					  << std::setw(10) << "scan ns" << '\n';
+			measure<sec_3_1::Customer>("std::vector<int>");
+			measure<sec_3_1::BasicCustomer<smallvector::small_vector<int, 10>>>("small_vector<int, 10>");
+			measure<sec_3_1::BasicCustomer<smallvector::small_vector<int, 4>>>("small_vector<int, 4>");
+		}
+	}
+
+	// a million customers by create_customer() vs. by the parallel generator (see customergen.h)
+	namespace sec_3_1d
+	{
+		const std::size_t num = 1'000'000;
+
+		template <typename Func>
+		double time_ms(Func&& func)
+		{
+			auto t0 = std::chrono::steady_clock::now();
+			func();
+			auto t1 = std::chrono::steady_clock::now();
+			return std::chrono::duration<double, std::milli>{ t1 - t0 }.count();
+		}
+
+		void run()
+		{
+			std::cout << std::fixed << std::setprecision(1);
+			double ms = time_ms([] {
+				std::vector<sec_3_1::Customer> coll;
+				coll.reserve(num);
+				for (std::size_t i = 0; i < num; ++i) {
+					coll.push_back(sec_3_1::create_customer());
+				}
+				benchmark::do_not_optimize(coll.data());
+			});
+			std::cout << "create_customer():        " << std::setw(8) << ms << "ms\n";
+
+			std::vector<sec_3_1::Customer> reference;
+			unsigned hw = std::max(std::thread::hardware_concurrency(), 1u);
+			for (unsigned threads : { 1u, 2u, 4u, hw }) {
+				std::vector<sec_3_1::Customer> coll;
+				ms = time_ms([&] {
+					coll = customergen::generate<sec_3_1::Customer>(num, threads);
+				});
+				if (reference.empty()) {
+					reference = std::move(coll);
+					std::cout << "generate() with " << std::setw(2) << threads << " threads: " << std::setw(8) << ms << "ms\n";
+					continue;
+				}
+				bool same = std::equal(coll.begin(), coll.end(), reference.begin(), reference.end(),
+									   [](const sec_3_1::Customer& a, const sec_3_1::Customer& b) {
+										   return a.get_name() == b.get_name() && a.get_values() == b.get_values();
+									   });
+				if (!same) {
+					throw std::runtime_error{ "generate() with " + std::to_string(threads) + " threads differs from 1 thread" };
+				}
+				std::cout << "generate() with " << std::setw(2) << threads << " threads: " << std::setw(8) << ms << "ms"
+						  << " (identical)\n";
+			}
+			std::cout << std::defaultfloat << "first customer: " << reference.front() << '\n';
+		}
+	}
+
+	// finding customers by name: linear scan vs. hash index with std::string_view lookup (see nameindex.h)
+	namespace sec_3_1e
+	{
+		const std::size_t num = 20'000;
+		const std::size_t probes = 1'000;
+
+		struct probe_stats {
+			double	ns;			// per probe
+			double	allocs;		// per probe
+		};
+
+		// probe all names (as views) with find_func, which returns whether it found the name
+		template <typename Find>
+		probe_stats measure(const char* what, const std::vector<std::string>& names, Find&& find_func)
+		{
+			std::size_t found = 0;
+			auto probe_all = [&] {
+				found = 0;
+				for (const std::string& name : names) {
+					if (find_func(std::string_view{ name })) {
+						++found;
+					}
+				}
+			};
+			double per_probe = static_cast<double>(names.size());
+			benchmark::measured res = benchmark::measure(what, benchmark::limited(10, per_probe), probe_all);
+			probe_stats stats{ res.time.median / per_probe, static_cast<double>(res.allocs) / per_probe };
+			std::cout << std::left << std::setw(40) << what << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(12) << stats.ns
+					  << std::setw(14) << alloccount::show(stats.allocs)
+					  << std::setw(8) << found << '\n'
+					  << std::defaultfloat;
+			return stats;
+		}
+
+		void run()
+		{
+			using sec_3_1::Customer;
+			std::vector<Customer> coll = customergen::generate<Customer>(num);
+
+			// every 10th probe misses
+			std::vector<std::string> names;
+			std::default_random_engine eng{ 42 };
+			std::uniform_int_distribution<std::size_t> pick{ 0, num - 1 };
+			for (std::size_t i = 0; i < probes; ++i) {
+				names.push_back(i % 10 == 9 ? " no such customer " + std::to_string(i) : coll[pick(eng)].get_name());
+			}
+
+			std::unordered_map<std::string, std::size_t> by_string;
+			for (std::size_t i = 0; i < coll.size(); ++i) {
+				by_string.emplace(coll[i].get_name(), i);
+			}
+
+			std::cout << std::left << std::setw(40) << "find " + std::to_string(probes) + " of " + std::to_string(num) << std::right
+					  << std::setw(12) << "ns/probe"
+					  << std::setw(14) << "allocs/probe"
+					  << std::setw(8) << "found" << '\n';
+			measure("linear scan with get_name()", names, [&](std::string_view name) {
+				return std::find_if(coll.begin(), coll.end(), [&](const Customer& cust) {
+					return cust.get_name() == name;
+				}) != coll.end();
+			});
+			measure("unordered_map<string>::find(string)", names, [&](std::string_view name) {
+				return by_string.find(std::string{ name }) != by_string.end();		// temporary key
+			});
+
+			// build the index from the moved-in customers
+			alloccount::scope build_allocs;
+			auto t0 = std::chrono::steady_clock::now();
+			nameindex::NameIndex<Customer> index{ std::move(coll) };
+			auto t1 = std::chrono::steady_clock::now();
+			std::size_t allocs = build_allocs.current().count;
+
+			measure("NameIndex::find(string_view)", names, [&](std::string_view name) {
+				return index.find(name) != nullptr;
+			});
+			std::cout << std::fixed << std::setprecision(1)
+					  << "build NameIndex from moved vector: "
+					  << std::chrono::duration<double, std::milli>{ t1 - t0 }.count() << "ms, "
+					  << alloccount::show(allocs) << " allocations (keys and nodes, the customers are moved)\n"
+					  << std::defaultfloat;
+
+			// erase moves the last customer into the gap, growing moves all of them;
+			// the index stays valid as it stores positions
+			for (std::size_t i = 0; i < num; i += 2) {
+				index.erase(customergen::make_customer<Customer>(i + 1).get_name());
+			}
+			for (std::size_t i = num; i < 2 * num; ++i) {
+				index.insert(customergen::make_customer<Customer>(i + 1));
+			}
+			bool valid = index.size() == num / 2 + num;
+			for (const Customer& cust : index.customers()) {
+				const Customer* found = index.find(cust.get_name());
+				valid = valid && found == &cust;
+			}
+			if (!valid) {
+				throw std::runtime_error{ "NameIndex is invalid after erase and insert" };
+			}
+			std::cout << "after " << num / 2 << " erases and " << num << " inserts: " << index.size()
+					  << " customers, index valid\n";
+		}
+	}
+
+	// aggregates over the values of a million customers: scalar vs. SIMD, objects vs. columns (see aggregate.h)
+	namespace sec_3_1f
+	{
+		const std::size_t num = 1'000'000;
+		const std::size_t k = 10;
+
+		// run the kernel in all variants (with all instruction sets if simd), print ns per value
+		// and whether the result matches the scalar one
+		template <typename Kernel>
+		void measure(const std::string& what, bool simd, Kernel&& kernel, const std::vector<sec_3_1::Customer>& coll,
+					 const customertable::CustomerTable& table, unsigned hw)
+		{
+			benchmark::config cfg = benchmark::limited(10);
+			double values = static_cast<double>(table.all_values().size());
+
+			auto reference = kernel(table.all_values(), 1, aggregate::isa::scalar);
+			auto row = [&](const std::string& variant, auto&& input, unsigned threads, aggregate::isa kind) {
+				auto res = benchmark::run(variant, [&] {
+					auto r = kernel(input, threads, kind);
+					benchmark::do_not_optimize(r);
+				}, cfg);
+				if (kernel(input, threads, kind) != reference) {
+					throw std::runtime_error{ what + " of " + variant + " differs from the scalar result" };
+				}
+				std::cout << std::left << std::setw(12) << what << std::setw(36) << variant << std::right
+						  << std::fixed << std::setprecision(3)
+						  << std::setw(10) << res.median / values
+						  << std::defaultfloat << '\n';
+			};
+			for (aggregate::isa kind : { aggregate::isa::scalar, aggregate::isa::sse2, aggregate::isa::avx2 }) {
+				if (!aggregate::available(kind) || (!simd && kind != aggregate::isa::scalar)) {
+					continue;
+				}
+				row(std::string{ "vector<Customer>, " } + aggregate::name(kind), coll, 1, kind);
+				row(std::string{ "CustomerTable values, " } + aggregate::name(kind), table.all_values(), 1, kind);
+			}
+			row("vector<Customer>, " + std::to_string(hw) + " threads", coll, hw, aggregate::best_isa);
+			row("CustomerTable values, " + std::to_string(hw) + " threads", table.all_values(), hw, aggregate::best_isa);
+		}
+
+		void run()
+		{
+			std::vector<sec_3_1::Customer> coll = customergen::generate<sec_3_1::Customer>(num);
+			customertable::CustomerTable table{ coll };
+			unsigned hw = std::max(std::thread::hardware_concurrency(), 1u);
+
+			std::cout << std::left << std::setw(12) << "kernel" << std::setw(36) << "input" << std::right
+					  << std::setw(10) << "ns/value" << '\n';
+			measure("summarize", true, [](const auto& input, unsigned threads, aggregate::isa kind) {
+				return threads > 1 ? aggregate::parallel_summarize(input, threads, kind) : aggregate::summarize(input, kind);
+			}, coll, table, hw);
+			measure("histogram", false, [](const auto& input, unsigned threads, aggregate::isa) {
+				return threads > 1 ? aggregate::parallel_histogram(input, threads) : aggregate::histogram_of(input);
+			}, coll, table, hw);
+			measure("top " + std::to_string(k), true, [](const auto& input, unsigned threads, aggregate::isa kind) {
+				return threads > 1 ? aggregate::parallel_top_k(input, k, threads, kind) : aggregate::top_k(input, k, kind);
+			}, coll, table, hw);
+
+			aggregate::summary s = aggregate::summarize(table.all_values());
+			std::vector<int> top = aggregate::top_k(table.all_values(), k);
+			std::cout << s.count << " values, sum " << s.sum << ", min " << s.min << ", max " << s.max
+					  << ", mean " << s.mean() << ", largest " << top.front() << '\n';
+		}
+	}
+
+	// loading a million customers from text vs. from a binary snapshot (see snapshot.h)
+	namespace sec_3_1g
+	{
+		using sec_3_1::Customer;
+
+		const std::size_t num = 1'000'000;
+
+		// one customer per line: name, tab, values separated by spaces
+		void write_text(const std::string& path, const std::vector<Customer>& coll)
+		{
+			std::ofstream strm{ path };
+			for (const Customer& cust : coll) {
+				strm << cust.get_name() << '\t';
+				for (int val : cust.get_values()) {
+					strm << val << ' ';
+				}
+				strm << '\n';
+			}
+		}
+
+		std::vector<Customer> read_text(const std::string& path)
+		{
+			std::vector<Customer> coll;
+			std::ifstream strm{ path };
+			std::string row;
+			while (std::getline(strm, row)) {
+				std::size_t tab = row.find('\t');
+				if (tab == std::string::npos) {
+					continue;		// not a customer line
+				}
+				Customer cust{ row.substr(0, tab) };
+				const char* pos = row.data() + tab + 1;
+				const char* end = row.data() + row.size();
+				int val;
+				std::from_chars_result res = std::from_chars(pos, end, val);
+				while (res.ec == std::errc{}) {
+					cust.add_value(val);
+					pos = res.ptr == end ? end : res.ptr + 1;		// skip the space
+					res = std::from_chars(pos, end, val);
+				}
+				coll.push_back(std::move(cust));
+			}
+			return coll;
+		}
+
+		// median of a few calls of func() (each handles all customers), reset() runs untimed before each
+		template <typename Reset, typename Func>
+		void measure(const char* what, Reset&& reset, Func&& func)
+		{
+			benchmark::config cfg = benchmark::limited(3);
+			cfg.warmup_samples = 0;
+			benchmark::measured res = benchmark::measure(what, cfg, reset, func);
+			std::cout << std::left << std::setw(40) << what << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(10) << res.time.median / 1e6
+					  << std::setw(12) << alloccount::show(res.allocs) << '\n'
+					  << std::defaultfloat;
+		}
+		template <typename Func>
+		void measure(const char* what, Func&& func)
+		{
+			measure(what, [] {}, func);
+		}
+
+		bool same(const std::vector<Customer>& a, const std::vector<Customer>& b)
+		{
+			return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+							  [](const Customer& c1, const Customer& c2) {
+								  return c1.get_name() == c2.get_name() && c1.get_values() == c2.get_values();
+							  });
+		}
+
+		void run()
+		{
+			std::vector<Customer> coll = customergen::generate<Customer>(num);
+			std::filesystem::path dir = std::filesystem::temp_directory_path();
+			std::string text_path = (dir / "sec_3_1g.txt").string();
+			std::string snap_path = (dir / "sec_3_1g.snap").string();
+
+			std::cout << std::left << std::setw(40) << std::to_string(num) + " customers" << std::right
+					  << std::setw(10) << "ms"
+					  << std::setw(12) << "allocs" << '\n';
+			measure("write text", [&] {
+				write_text(text_path, coll);
+			});
+			measure("write snapshot", [&] {
+				snapshot::save(snap_path, coll);
+			});
+			std::vector<Customer> from_text;
+			measure("read text into std::vector<Customer>", [&] {
+				from_text = std::vector<Customer>{};
+			}, [&] {
+				from_text = read_text(text_path);
+			});
+			std::optional<snapshot::file> snap;
+			measure("load snapshot (map, check offsets)", [&] {
+				snap.reset();
+			}, [&] {
+				snap.emplace(snapshot::file::load(snap_path));
+			});
+			long long sum = 0;
+			measure("  sum the values of the views", [&] {
+				sum = 0;
+				for (std::size_t i = 0; i < snap->size(); ++i) {
+					for (int val : (*snap)[i].get_values()) {
+						sum += val;
+					}
+				}
+			});
+			std::vector<Customer> from_snap;
+			measure("  to_customers(), 1 thread", [&] {
+				from_snap = std::vector<Customer>{};
+			}, [&] {
+				from_snap = snap->to_customers<Customer>(1);
+			});
+			unsigned hw = std::max(std::thread::hardware_concurrency(), 1u);
+			std::string what = "  to_customers(), " + std::to_string(hw) + " threads";
+			std::vector<Customer> from_snap_mt;
+			measure(what.c_str(), [&] {
+				from_snap_mt = std::vector<Customer>{};
+			}, [&] {
+				from_snap_mt = snap->to_customers<Customer>(hw);
+			});
+
+			std::cout << "text: " << std::filesystem::file_size(text_path) / 1024 << " KiB, snapshot: "
+					  << std::filesystem::file_size(snap_path) / 1024 << " KiB"
+					  << (snap->mapped() ? " (mapped)" : "") << ", sum " << sum << '\n';
+			bool identical = same(coll, from_text) && same(coll, from_snap) && same(coll, from_snap_mt);
+			std::filesystem::remove(text_path);
+			std::filesystem::remove(snap_path);
+			if (!identical) {
+				throw std::runtime_error{ "customers read back differ from the written ones" };
+			}
+		}
+	}
+
+	// printing customers through iostream formatting vs. into a char buffer with std::to_chars() (see customerfmt.h)
+	namespace sec_3_1h
+	{
+		using sec_3_1::Customer;
+
+		const std::size_t num = 200'000;
+
+		// operator<< as sec_3_2 had it: the customer by value, every item through the stream
+		void print_by_value(std::ostream& strm, const Customer cust)
+		{
+			strm << '[' << cust.get_name() << ": ";
+			for (int val : cust.get_values()) {
+				strm << val << ' ';
+			}
+			strm << ']';
+		}
+
+		// the same by reference
+		void print_by_ref(std::ostream& strm, const Customer& cust)
+		{
+			strm << '[' << cust.get_name() << ": ";
+			for (int val : cust.get_values()) {
+				strm << val << ' ';
+			}
+			strm << ']';
+		}
+
+		template <typename Print>
+		void measure(const char* what, std::ofstream& strm, Print&& print)
+		{
+			benchmark::measured res = benchmark::measure(what, benchmark::limited(10, static_cast<double>(num)), [&] {
+				strm.seekp(0);
+				print(strm);
+				strm.flush();
+			});
+			std::size_t count = res.allocs;
+			double per_s = static_cast<double>(num) * 1e9 / res.time.median;
+			std::cout << std::left << std::setw(36) << what << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(14) << per_s / 1e6
+					  << std::setw(16) << alloccount::show(static_cast<double>(count) / static_cast<double>(num)) << '\n'
+					  << std::defaultfloat;
+		}
+
+		void run()
+		{
+			std::vector<Customer> coll = customergen::generate<Customer>(num);
+			std::string path = (std::filesystem::temp_directory_path() / "sec_3_1h.txt").string();
+			std::ofstream strm{ path };
+
+			std::cout << std::left << std::setw(36) << "print " + std::to_string(num) + " customers" << std::right
+					  << std::setw(14) << "M customers/s"
+					  << std::setw(16) << "allocs/customer" << '\n';
+			measure("iostream, Customer by value", strm, [&](std::ostream& out) {
+				for (const Customer& cust : coll) {
+					print_by_value(out, cust);
+					out << '\n';
+				}
+			});
+			measure("iostream, Customer by reference", strm, [&](std::ostream& out) {
+				for (const Customer& cust : coll) {
+					print_by_ref(out, cust);
+					out << '\n';
+				}
+			});
+			measure("operator<< (writer on the stack)", strm, [&](std::ostream& out) {
+				for (const Customer& cust : coll) {
+					out << cust << '\n';
+				}
+			});
+			measure("customerfmt::writer::lines()", strm, [&](std::ostream& out) {
+				customerfmt::writer writer{ out };
+				writer.lines(coll);
+			});
+			strm.close();
+
+			std::ostringstream old_way;
+			std::ostringstream new_way;
+			print_by_ref(old_way, coll.front());
+			new_way << coll.front();
+			std::filesystem::remove(path);
+			if (old_way.str() != new_way.str()) {
+				throw std::runtime_error{ "operator<< prints \"" + new_way.str() + "\" instead of \"" + old_way.str() + '"' };
+			}
+			std::cout << "first customer: " << new_way.str() << " (same output)\n";
+		}
+	}
+
 	namespace sec_3_2
 	{
-		class Customer
+		class Customer : public smfcount::counted<Customer>	// counts copies and moves (print them with --trace)
 		{
 		private:
 			std::string			m_name;		// name of the customer
@@ -111,7 +792,7 @@ namespace chapter_3
 				: m_name{ n }
 			{
 				assert(!m_name.empty());
-				std::cout << "CONSTRUCT " << m_name << '\n';
+				trace("CONSTRUCT ", m_name);
 			}
 
 			std::string get_name() const
@@ -124,7 +805,7 @@ namespace chapter_3
 				m_values.push_back(val);
 			}
 
-			friend std::ostream& operator<<(std::ostream& strm, const Customer cust)
+			friend std::ostream& operator<<(std::ostream& strm, const Customer& cust)
 			{
 				strm << '[' << cust.m_name << ": ";
 				for (int val : cust.m_values) {
@@ -137,22 +818,23 @@ namespace chapter_3
 
 			// copy constructor (copy all members):
 			Customer(const Customer& cust)
-				: m_name{cust.m_name}, m_values {cust.m_values}
+				: counted{cust}, m_name{cust.m_name}, m_values {cust.m_values}
 			{
-				std::cout << "COPY " << cust.m_name << '\n';
+				trace("COPY ", cust.m_name);
 			}
 
 			// move constructor (move all members):
 			Customer(Customer&& cust)		// noexcept declaraton missing
-				: m_name{std::move(cust.m_name)}, m_values{std::move(cust.m_values)}
+				: counted{std::move(cust)}, m_name{std::move(cust.m_name)}, m_values{std::move(cust.m_values)}
 			{
-				std::cout << "MOVE " << m_name << '\n';
+				trace("MOVE ", m_name);
 			}
 
 			// copy assignment (assign all members):
 			Customer& operator= (const Customer& cust)
 			{
-				std::cout << "COPY ASSIGN " << cust.m_name << '\n';
+				trace("COPY ASSIGN ", cust.m_name);
+				counted::operator=(cust);
 				m_name = cust.m_name;
 				m_values = cust.m_values;
 				return *this;
@@ -161,7 +843,8 @@ namespace chapter_3
 			// move assignment (move all members):
 			Customer& operator= (Customer&& cust)
 			{
-				std::cout << "MOVE ASSIGN " << cust.m_name << '\n';
+				trace("MOVE ASSIGN ", cust.m_name);
+				counted::operator=(std::move(cust));
 				m_name = std::move(cust.m_name);
 				m_values = std::move(cust.m_values);
 				/*
@@ -206,6 +889,68 @@ namespace chapter_3
 		}
 	}
 
+	// sorting a million customers as run_2() does vs. with cached keys (see keysort.h)
+	namespace sec_3_2b
+	{
+		using sec_3_2::Customer;
+
+		const std::size_t num = 1'000'000;
+
+		// a few sorts of a copy of input are enough at this size
+		template <typename Sort>
+		void measure(const char* what, const std::vector<Customer>& input, Sort&& sort)
+		{
+			benchmark::config cfg = benchmark::limited(3);
+			cfg.warmup_samples = 0;
+			std::vector<Customer> coll;
+			std::size_t moves = 0;		// of the last sort
+			benchmark::measured res = benchmark::measure(what, cfg, [&] {
+				coll = std::vector<Customer>{};		// a fresh copy (assigning would reuse the sorted, scattered strings)
+				coll = input;
+			}, [&] {
+				smfcount::tally before = Customer::totals();
+				sort(coll);
+				smfcount::tally after = Customer::totals();
+				moves = after[smfcount::move_construct] + after[smfcount::move_assign]
+					- before[smfcount::move_construct] - before[smfcount::move_assign];
+			});
+
+			std::cout << std::left << std::setw(32) << what << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(10) << res.time.median / 1e6
+					  << std::setw(14) << alloccount::show(res.allocs)
+					  << std::setw(14) << moves << '\n'
+					  << std::defaultfloat;
+		}
+
+		void run()
+		{
+			std::vector<Customer> input = customergen::generate<Customer>(num);
+			std::shuffle(input.begin(), input.end(), std::default_random_engine{ 42 });
+
+			std::cout << std::left << std::setw(32) << "sort " + std::to_string(num) + " customers" << std::right
+					  << std::setw(10) << "ms"
+					  << std::setw(14) << "allocs"
+					  << std::setw(14) << "moves" << '\n';
+			measure("std::sort() by get_name()", input, [](std::vector<Customer>& coll) {
+				std::sort(coll.begin(), coll.end(),
+					[](const Customer& c1, const Customer& c2) {
+						return c1.get_name() < c2.get_name();
+					});
+			});
+			auto key = [](const Customer& c) {
+				return c.get_name();
+			};
+			measure("keysort::sort_by_key()", input, [&](std::vector<Customer>& coll) {
+				keysort::sort_by_key(coll, key);
+			});
+			unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+			measure(("parallel_sort_by_key(), " + std::to_string(threads) + " thr").c_str(), input, [&](std::vector<Customer>& coll) {
+				keysort::parallel_sort_by_key(coll, key, threads);
+			});
+		}
+	}
+
 	// By Default, We Have Copying and Moving
 	namespace sec_3_3_2
 	{
@@ -383,7 +1128,7 @@ namespace chapter_3
 
 			// NO destructor
 		};
-		class Customer
+		class Customer : public smfcount::counted<Customer>
 		{
 		private:
 			std::string			m_name;		// name of the customer
@@ -395,7 +1140,7 @@ namespace chapter_3
 				: m_name{ n }
 			{
 				assert(!m_name.empty());
-				std::cout << "CONSTRUCT " << m_name << '\n';
+				trace("CONSTRUCT ", m_name);
 			}
 
 			std::string get_name() const
@@ -408,7 +1153,7 @@ namespace chapter_3
 				m_values.push_back(val);
 			}
 
-			friend std::ostream& operator<<(std::ostream& strm, const Customer cust)
+			friend std::ostream& operator<<(std::ostream& strm, const Customer& cust)
 			{
 				strm << '[' << cust.m_name << ": ";
 				for (int val : cust.m_values) {
@@ -534,6 +1279,8 @@ namespace chapter_3
 			{}
 			// the generated move constructor will move m_id string but copy the
 			// Customer cust because move semantics is disabled for Customer
+			// (reported by movecheck, see sec_3_3_7b)
+			MOVECHECK_MEMBERS(m_id, m_cust)
 		};
 
 		void run()
@@ -543,6 +1290,63 @@ namespace chapter_3
 		}
 	}
 
+	// detecting members that are copied when the enclosing class moves (see movecheck.h)
+	namespace sec_3_3_7b
+	{
+		// Invoice with a customer that moves
+		class Invoice
+		{
+		private:
+			std::string			m_id;
+			sec_3_1::Customer	m_cust;
+		public:
+			Invoice(std::string id, sec_3_1::Customer c)
+				: m_id{ std::move(id) }, m_cust{ std::move(c) }
+			{}
+			MOVECHECK_MEMBERS(m_id, m_cust)
+		};
+
+		// a destructor declared "for logging" disables the move operations silently
+		class Entry
+		{
+		private:
+			std::string	m_text;
+		public:
+			Entry(std::string t)
+				: m_text{ std::move(t) }
+			{}
+			~Entry()
+			{}
+			MOVECHECK_MEMBERS(m_text)
+		};
+
+		class Journal
+		{
+		private:
+			const std::string	m_owner;	// const members can't be moved from
+			std::vector<Entry>	m_entries;
+			Entry				m_last{ "" };
+		public:
+			MOVECHECK_MEMBERS(m_owner, m_entries, m_last)
+		};
+
+		// hot value types: a build fails as soon as one of them starts copying on move
+		static_assert(movecheck::is_cheaply_movable_v<sec_3_1::Customer>);
+		static_assert(movecheck::is_cheaply_movable_v<customertable::CustomerTable>);
+		static_assert(movecheck::is_cheaply_movable_v<smallvector::small_vector<int, 10>>);
+		static_assert(movecheck::is_cheaply_movable_v<Invoice>);
+		static_assert(!movecheck::is_cheaply_movable_v<sec_3_3_7::Invoice>);
+		static_assert(!movecheck::is_cheaply_movable_v<Journal>);
+
+		void run()
+		{
+			movecheck::report<sec_3_3_7::Invoice>(std::cout, "sec_3_3_7::Invoice");
+			movecheck::report<Invoice>(std::cout, "sec_3_3_7b::Invoice");
+			movecheck::report<Entry>(std::cout, "sec_3_3_7b::Entry");
+			movecheck::report<Journal>(std::cout, "sec_3_3_7b::Journal");
+		}
+	}
+
 	// Exact Rules for Generated Special Member Functions
 	namespace sec_3_3_8
 	{
@@ -6,6 +6,29 @@
 #include <chrono>
 #include <ratio>
 #include <array>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <type_traits>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "chapter_2.h"
+#include "chapter_3.h"
+#include "alloccount.h"
+#include "benchmark.h"
+#include "boxed.h"
+#include "coordbuffer.h"
+#include "fwdinit.h"
+#include "geometry.h"
+#include "relocate.h"
+#include "setter.h"
+#include "linereader.h"
 
 namespace chapter_4
 {
@@ -59,6 +82,13 @@ namespace chapter_4
 				coll.push_back(std::move(line));	// move (we no longer need the value of line)
 			}
 		}
+
+		void run3(void)
+		{
+			linereader::lines coll = linereader::lines::from_stdin();	// views into one buffer, no allocation per line
+			std::vector<std::string> owned = coll.materialize();		// only if the lines must outlive the buffer
+			benchmark::do_not_optimize(owned.size());
+		}
 	}
 
 	// Avoid Unnecessary std::move
@@ -371,44 +401,52 @@ namespace chapter_4
 				:m_first{ std::move(f) }, m_last{ l }
 			{}
 		};
-		// measure num initializations of whatever is currently defined as Person
-		std::chrono::nanoseconds measure(int num)
+
+		// the same with one constrained forwarding constructor (see fwdinit.h)
+		class FwdPerson {
+		private:
+			std::string m_first;
+			std::string m_last;
+		public:
+			template <fwdinit::arg_for<std::string, FwdPerson> F, fwdinit::arg_for<std::string, FwdPerson> L>
+			FwdPerson(F&& f, L&& l)
+				:m_first{ std::forward<F>(f) }, m_last{ std::forward<L>(l) }
+			{}
+		};
+
+		// measure num initializations of P (Person or FwdPerson)
+		template <typename P>
+		std::chrono::nanoseconds measure(std::size_t num)
 		{
-			std::chrono::nanoseconds total_dur{ 0 };
-			for (size_t i = 0; i < static_cast<size_t>(num); i++) {
+			benchmark::stopwatch watch;		// also counts hardware events with --perf
+			for (size_t i = 0; i < num; i++) {
 				std::string fname = "a firstname a bit too long for SSO";
 				std::string lname = "a lastname a bit too long for SSO";
 				// measure how long it takes to create 3 persons in different ways:
-				auto t0 = std::chrono::steady_clock::now();
-					Person p1 { "a firstname a bit too long for SSO","a lastname a bit too long for SSO" };
-					Person p2 { fname, lname };
-					Person p3 { std::move(fname), std::move(lname) };
-				auto t1 = std::chrono::steady_clock::now();
-				total_dur += t1 - t0;
+				watch.start();
+					P p1 { "a firstname a bit too long for SSO","a lastname a bit too long for SSO" };
+					P p2 { fname, lname };
+					P p3 { std::move(fname), std::move(lname) };
+					benchmark::do_not_optimize(p1);		// keep the compiler from dropping the inits
+					benchmark::do_not_optimize(p2);
+					benchmark::do_not_optimize(p3);
+				watch.stop();
 			}
-			return total_dur;
+			return watch.elapsed();
 		}
 
 		void run(void)
 		{
 			std::cout << "chapter_4::sec_4_3_4\n";
-			int  num = 1000;	// num iterations to measure
-
-			// a few iterations to avoid measuring initial behaviour, ignore return
-			auto _ = measure(5);
 
-			// measure (in integral nano and floating point milliseconds)
-			std::chrono::nanoseconds ns_dur { measure(num) };
-			std::chrono::duration<double, std::milli> ms_dur { ns_dur };
-
-			// print result
-			std::cout << num << " iterations take: "
-					  << ms_dur.count() << "ms\n";
-			std::cout << " 3 inits take on average: "
-					  << ns_dur.count() / num << "ns\n";
+			// calibrates the iterations, warms up and reports the distribution of
+			// the time 3 inits take (instead of a single average)
+			benchmark::run_manual("3 Person inits (9 overloads)", measure<Person>);
+			benchmark::run_manual("3 Person inits (forwarding)", measure<FwdPerson>);
 		}
 
 		// expensive members that will not benefit from move
+		// (unless they are kept on the heap, see boxed.h and sec_4_3_5b)
 		class Person2 {
 		private:
 			std::string m_name;
@@ -417,6 +455,278 @@ namespace chapter_4
 		};
 	}
 
+	// Benchmark matrix: every way to pass the names against every kind of argument
+	// (the constructors of sec_4_3_1 .. sec_4_3_4 and the functions of chapter_2::sec_2_5)
+	namespace sec_4_3_4b
+	{
+		// perfect forwarding (the strategy the book has not measured above)
+		class Person {
+		private:
+			std::string m_first;
+			std::string m_last;
+		public:
+			template <fwdinit::arg_for<std::string, Person> F, fwdinit::arg_for<std::string, Person> L>
+			Person(F&& f, L&& l)
+				: m_first{ std::forward<F>(f) }, m_last{ std::forward<L>(l) }
+			{}
+		};
+
+		// the parameter passing of chapter_2::sec_2_5 as a "constructor" that passes both names
+		// to Func (foo_by_value() consumes its argument, foo_by_ref() takes no lvalues)
+		template <auto Func>
+		class Call {
+		public:
+			template <typename F, typename L>
+				requires std::invocable<decltype(Func), F&&> && std::invocable<decltype(Func), L&&>
+			Call(F&& f, L&& l)
+			{
+				Func(std::forward<F>(f));
+				Func(std::forward<L>(l));
+			}
+		};
+
+		enum class category { lvalue, xvalue, prvalue, literal };
+
+		inline constexpr const char* category_names[]{ "lvalue", "xvalue", "prvalue", "literal" };
+
+		// P can be initialized from two names of category Cat
+		template <typename P, category Cat>
+		constexpr bool accepts() noexcept
+		{
+			if constexpr (Cat == category::lvalue) {
+				return std::is_constructible_v<P, std::string&, std::string&>;
+			}
+			else if constexpr (Cat == category::literal) {
+				return std::is_constructible_v<P, const char*, const char*>;
+			}
+			else {
+				return std::is_constructible_v<P, std::string&&, std::string&&>;
+			}
+		}
+
+		struct result {
+			const char*	strategy;
+			category	cat;
+			std::size_t	len;				// characters per name
+			double		ns_per_init;		// median (including the destruction of the Person)
+			std::size_t	allocs_per_init;	// without creating the arguments of lvalues and xvalues
+		};
+
+		// create a P from two names of the given category (arguments prepared by the caller)
+		template <typename P, category Cat>
+		void init(std::string& f, std::string& l, const char* text)
+		{
+			if constexpr (Cat == category::lvalue) {
+				P p{ f, l };
+				benchmark::do_not_optimize(p);
+			}
+			else if constexpr (Cat == category::xvalue) {
+				P p{ std::move(f), std::move(l) };
+				benchmark::do_not_optimize(p);
+			}
+			else if constexpr (Cat == category::prvalue) {
+				P p{ std::string{ text }, std::string{ text } };
+				benchmark::do_not_optimize(p);
+			}
+			else {
+				P p{ text, text };
+				benchmark::do_not_optimize(p);
+			}
+		}
+
+		template <typename P, category Cat>
+		result measure(const char* strategy, const char* text, const benchmark::config& cfg)
+		{
+			// time batches of inits, so the clock reads do not dominate
+			constexpr std::size_t batch = 64;
+			benchmark::config batch_cfg{ cfg };
+			batch_cfg.items = batch;
+			std::vector<std::string> firsts(batch);
+			std::vector<std::string> lasts(batch);
+			benchmark::measured res = benchmark::measure(strategy, batch_cfg, [&] {
+				for (std::size_t j = 0; j < batch; ++j) {
+					firsts[j] = text;		// the arguments exist before the call
+					lasts[j] = text;
+				}
+			}, [&] {
+				for (std::size_t j = 0; j < batch; ++j) {
+					init<P, Cat>(firsts[j], lasts[j], text);
+				}
+			});
+			return result{ strategy, Cat, std::strlen(text), res.time.median / batch, res.allocs / batch };
+		}
+
+		template <typename P>
+		void measure(const char* strategy, const benchmark::config& cfg)
+		{
+			// names below and above the SSO threshold (15 or 22 characters)
+			static const char* const texts[]{ "Jane", "a firstname a bit too long for SSO" };
+			auto row = [&]<category Cat>() {
+				if constexpr (!accepts<P, Cat>()) {
+					if (!cfg.json) {
+						std::cout << std::left << std::setw(18) << strategy
+								  << std::setw(10) << category_names[static_cast<int>(Cat)] << std::right
+								  << std::setw(10) << "-" << std::setw(8) << "-"
+								  << std::setw(10) << "-" << std::setw(8) << "-" << '\n';
+					}
+				}
+				else {
+					result sso = measure<P, Cat>(strategy, texts[0], cfg);
+					result heap = measure<P, Cat>(strategy, texts[1], cfg);
+					if (cfg.json) {
+						for (const result& res : { sso, heap }) {
+							std::cout << "{\"name\":\"pass\",\"strategy\":\"" << res.strategy << '"'
+									  << ",\"argument\":\"" << category_names[static_cast<int>(res.cat)] << '"'
+									  << ",\"length\":" << res.len
+									  << ",\"ns_per_init\":" << res.ns_per_init
+									  << ",\"allocs_per_init\":" << alloccount::show(res.allocs_per_init, true) << "}\n";
+						}
+						return;
+					}
+					std::cout << std::left << std::setw(18) << strategy
+							  << std::setw(10) << category_names[static_cast<int>(Cat)] << std::right
+							  << std::fixed << std::setprecision(1)
+							  << std::setw(10) << sso.ns_per_init
+							  << std::setw(8) << alloccount::show(sso.allocs_per_init)
+							  << std::setw(10) << heap.ns_per_init
+							  << std::setw(8) << alloccount::show(heap.allocs_per_init) << '\n'
+							  << std::defaultfloat;
+				}
+			};
+			row.template operator()<category::lvalue>();
+			row.template operator()<category::xvalue>();
+			row.template operator()<category::prvalue>();
+			row.template operator()<category::literal>();
+		}
+
+		void run()
+		{
+			benchmark::config cfg = benchmark::limited(15);
+			cfg.min_sample_time = std::min(cfg.min_sample_time, std::chrono::nanoseconds{ std::chrono::milliseconds{ 2 } });
+
+			if (!cfg.json) {
+				std::cout << std::left << std::setw(18) << "strategy"
+						  << std::setw(10) << "argument" << std::right
+						  << std::setw(10) << "SSO ns"
+						  << std::setw(8) << "allocs"
+						  << std::setw(10) << "heap ns"
+						  << std::setw(8) << "allocs" << '\n';
+			}
+			measure<sec_4_3_1::Person>("const&", cfg);
+			measure<sec_4_3_2::Person>("by value + move", cfg);
+			measure<sec_4_3_4::Person>("&& overloads", cfg);
+			measure<sec_4_3_4b::Person>("forwarding", cfg);
+			measure<Call<&chapter_2::sec_2_5::foo_by_value>>("foo_by_value()", cfg);
+			measure<Call<&chapter_2::sec_2_5::foo_by_ref>>("foo_by_ref()", cfg);
+		}
+	}
+
+	// Records with 8 string members: const&, by value + move and forwarding (see fwdinit.h)
+	// (the && overloads would take 3^8 = 6561 constructors)
+	namespace sec_4_3_4c
+	{
+		using sec_4_3_4b::category;
+		using sec_4_3_4b::category_names;
+
+		constexpr std::size_t fields = 8;
+		const char* const text = "a field value a bit too long for SSO";
+
+		class ConstRefRecord {
+		private:
+			std::array<std::string, fields> m_fields;
+		public:
+			ConstRefRecord(const std::string& a, const std::string& b, const std::string& c, const std::string& d,
+						   const std::string& e, const std::string& f, const std::string& g, const std::string& h)
+				: m_fields{ a, b, c, d, e, f, g, h }
+			{}
+		};
+
+		class ValueRecord {
+		private:
+			std::array<std::string, fields> m_fields;
+		public:
+			ValueRecord(std::string a, std::string b, std::string c, std::string d,
+						std::string e, std::string f, std::string g, std::string h)
+				: m_fields{ std::move(a), std::move(b), std::move(c), std::move(d),
+							std::move(e), std::move(f), std::move(g), std::move(h) }
+			{}
+		};
+
+		class FwdRecord : public fwdinit::record<std::string, std::string, std::string, std::string,
+												 std::string, std::string, std::string, std::string> {
+		public:
+			using record::record;
+		};
+
+		template <typename R, category Cat, std::size_t... I>
+		void init(std::array<std::string, fields>& args, std::index_sequence<I...>)
+		{
+			if constexpr (Cat == category::lvalue) {
+				R r{ args[I]... };
+				benchmark::do_not_optimize(r);
+			}
+			else if constexpr (Cat == category::xvalue) {
+				R r{ std::move(args[I])... };
+				benchmark::do_not_optimize(r);
+			}
+			else if constexpr (Cat == category::prvalue) {
+				R r{ std::string{ (static_cast<void>(I), text) }... };
+				benchmark::do_not_optimize(r);
+			}
+			else {
+				R r{ (static_cast<void>(I), text)... };
+				benchmark::do_not_optimize(r);
+			}
+		}
+
+		template <typename R, category Cat>
+		void measure(const char* strategy, const benchmark::config& cfg)
+		{
+			constexpr std::size_t batch = 16;
+			benchmark::config batch_cfg{ cfg };
+			batch_cfg.items = batch;
+			std::vector<std::array<std::string, fields>> args(batch);
+			benchmark::measured res = benchmark::measure(strategy, batch_cfg, [&] {
+				for (auto& arg : args) {
+					arg.fill(text);		// the arguments exist before the call
+				}
+			}, [&] {
+				for (auto& arg : args) {
+					init<R, Cat>(arg, std::make_index_sequence<fields>{});
+				}
+			});
+			std::cout << std::left << std::setw(18) << strategy
+					  << std::setw(10) << category_names[static_cast<int>(Cat)] << std::right
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(10) << res.time.median / batch
+					  << std::setw(8) << alloccount::show(res.allocs / batch) << '\n'
+					  << std::defaultfloat;
+		}
+
+		template <typename R>
+		void measure(const char* strategy, const benchmark::config& cfg)
+		{
+			measure<R, category::lvalue>(strategy, cfg);
+			measure<R, category::xvalue>(strategy, cfg);
+			measure<R, category::prvalue>(strategy, cfg);
+			measure<R, category::literal>(strategy, cfg);
+		}
+
+		void run()
+		{
+			benchmark::config cfg = benchmark::limited(15);
+			cfg.min_sample_time = std::min(cfg.min_sample_time, std::chrono::nanoseconds{ std::chrono::milliseconds{ 2 } });
+
+			std::cout << std::left << std::setw(18) << "8 fields"
+					  << std::setw(10) << "argument" << std::right
+					  << std::setw(10) << "ns"
+					  << std::setw(8) << "allocs" << '\n';
+			measure<ConstRefRecord>("const&", cfg);
+			measure<ValueRecord>("by value + move", cfg);
+			measure<FwdRecord>("fwdinit::record", cfg);
+		}
+	}
+
 	// Summary for Member Initialization
 	namespace sec_4_3_5
 	{
@@ -450,6 +760,95 @@ namespace chapter_4
 		};
 	}
 
+	// Records with large array members: in place vs. boxed on the heap (see boxed.h)
+	namespace sec_4_3_5b
+	{
+		// a telemetry record with a fixed-size sample buffer
+		template <typename Samples>
+		struct Record {
+			long		id;
+			std::string	source;
+			Samples		samples;
+		};
+
+		struct result {
+			double		grow_ms;
+			std::size_t	grow_allocs;
+			double		sort_ms;
+		};
+
+		// the records in the order of ids (no reserve(): every reallocation moves all records)
+		template <typename Samples>
+		std::vector<Record<Samples>> grow(const std::vector<long>& ids)
+		{
+			std::vector<Record<Samples>> coll;
+			for (long id : ids) {
+				coll.push_back(Record<Samples>{ id, "sensor", Samples{} });
+			}
+			return coll;
+		}
+
+		template <typename Samples>
+		result measure(std::size_t num)
+		{
+			std::vector<long> ids(num);
+			for (std::size_t i = 0; i < num; ++i) {
+				ids[i] = static_cast<long>(i);
+			}
+			std::shuffle(ids.begin(), ids.end(), std::default_random_engine{ 42 });
+
+			benchmark::config cfg = benchmark::limited(5, static_cast<double>(num));
+			std::vector<Record<Samples>> coll;
+			benchmark::measured grown = benchmark::measure("grow", cfg, [&] {
+				coll = std::vector<Record<Samples>>{};		// release all memory (= {} would keep the capacity)
+			}, [&] {
+				coll = grow<Samples>(ids);
+			});
+			benchmark::measured sorted = benchmark::measure("sort", cfg, [&] {
+				coll = grow<Samples>(ids);
+			}, [&] {
+				std::sort(coll.begin(), coll.end(), [](const Record<Samples>& a, const Record<Samples>& b) {
+					return a.id < b.id;
+				});
+			});
+			return result{ grown.time.median / 1e6, grown.allocs, sorted.time.median / 1e6 };
+		}
+
+		template <typename Samples>
+		void row(const char* samples, std::size_t num)
+		{
+			result res = measure<Samples>(num);
+			std::cout << std::left << std::setw(34) << samples << std::right
+					  << std::setw(8) << sizeof(Record<Samples>)
+					  << std::fixed << std::setprecision(1)
+					  << std::setw(10) << res.grow_ms
+					  << std::setw(10) << alloccount::show(res.grow_allocs)
+					  << std::setw(10) << res.sort_ms << '\n'
+					  << std::defaultfloat;
+		}
+
+		void run()
+		{
+			std::cout << std::left << std::setw(34) << "samples" << std::right
+					  << std::setw(8) << "sizeof"
+					  << std::setw(10) << "grow ms"
+					  << std::setw(10) << "allocs"
+					  << std::setw(10) << "sort ms" << '\n';
+
+			const std::size_t num = 20'000;
+			std::cout << num << " records with 1000 samples:\n";
+			row<std::array<double, 1000>>("std::array<double, 1000>", num);
+			row<boxed::boxed<std::array<double, 1000>>>("boxed<std::array<double, 1000>>", num);
+			row<boxed::boxed<std::array<double, 1000>, 256>>("boxed<..., 256> (on the heap)", num);
+
+			const std::size_t small = 200'000;
+			std::cout << small << " records with 16 samples:\n";
+			row<std::array<double, 16>>("std::array<double, 16>", small);
+			row<boxed::boxed<std::array<double, 16>>>("boxed<std::array<double, 16>>", small);
+			row<boxed::boxed<std::array<double, 16>, 256>>("boxed<..., 256> (inline)", small);
+		}
+	}
+
 	// Should We Now Always Pass by Value and Move?
 	// .... it depends.
 	namespace sec_4_3_6
@@ -545,6 +944,133 @@ namespace chapter_4
 
 	}
 
+	// Setter policies against streams of updates (see setter.h)
+	namespace sec_4_3_6b
+	{
+		const std::size_t updates = 10'000;
+
+		template <typename Policy>
+		class Person {
+		private:
+			setter::field<std::string, Policy> m_first;
+			std::string m_last;
+		public:
+			Person(std::string f, std::string l)
+				: m_first{ std::move(f) }, m_last{ std::move(l) }
+			{}
+
+			template <typename S>
+			void set_first_name(S&& s)
+			{
+				m_first.set(std::forward<S>(s));
+			}
+			const std::string& get_first_name() const
+			{
+				return m_first.get();
+			}
+		};
+
+		enum class pattern { alternating, same_length, growing };
+		enum class arg { lvalue, rvalue, literal };
+
+		inline constexpr const char* pattern_names[]{ "alternating", "same length", "growing" };
+		inline constexpr const char* arg_names[]{ "std::string&", "std::string&&", "const char*" };
+
+		// the names of one update stream
+		std::vector<std::string> stream_of(pattern pat)
+		{
+			std::vector<std::string> names;
+			std::default_random_engine eng{ 42 };
+			std::uniform_int_distribution<std::size_t> near{ 30, 34 };
+			for (std::size_t i = 0; i < updates; ++i) {
+				std::size_t len = 0;
+				switch (pat) {
+				case pattern::alternating:
+					len = i % 2 == 0 ? 5 : 40;		// short (SSO) and long
+					break;
+				case pattern::same_length:
+					len = near(eng);
+					break;
+				case pattern::growing:
+					len = 16 + i % 200;				// grows, then starts short again
+					break;
+				}
+				names.push_back(std::string(len, static_cast<char>('a' + i % 26)));
+			}
+			return names;
+		}
+
+		struct result {
+			double ns;		// per update
+			double allocs;	// per update
+		};
+
+		// one pass over the stream (moved holds the rvalues)
+		template <typename Policy>
+		void apply(Person<Policy>& p, const std::vector<std::string>& names, std::vector<std::string>& moved, arg kind)
+		{
+			for (std::size_t i = 0; i < names.size(); ++i) {
+				switch (kind) {
+				case arg::lvalue:
+					p.set_first_name(names[i]);
+					break;
+				case arg::rvalue:
+					p.set_first_name(std::move(moved[i]));
+					break;
+				case arg::literal:
+					p.set_first_name(names[i].c_str());
+					break;
+				}
+			}
+		}
+
+		template <typename Policy>
+		result replay(const std::vector<std::string>& names, arg kind)
+		{
+			double num = static_cast<double>(names.size());
+			std::optional<Person<Policy>> p;
+			std::vector<std::string> moved;
+			benchmark::measured res = benchmark::measure("replay", benchmark::limited(10, num), [&] {
+				p.emplace("Ben", "Cook");
+				if (kind == arg::rvalue) {
+					moved = names;		// the rvalues exist before the updates
+				}
+			}, [&] {
+				apply(*p, names, moved, kind);
+			});
+			return result{ res.time.median / num, static_cast<double>(res.allocs) / num };
+		}
+
+		template <typename Policy>
+		void measure(const char* policy, const std::vector<std::vector<std::string>>& streams)
+		{
+			for (arg kind : { arg::lvalue, arg::rvalue, arg::literal }) {
+				std::cout << std::left << std::setw(16) << policy
+						  << std::setw(15) << arg_names[static_cast<int>(kind)] << std::right
+						  << std::fixed << std::setprecision(2);
+				for (const std::vector<std::string>& names : streams) {
+					result res = replay<Policy>(names, kind);
+					std::cout << std::setw(8) << alloccount::show(res.allocs) << std::setw(8) << std::setprecision(1) << res.ns << std::setprecision(2);
+				}
+				std::cout << '\n' << std::defaultfloat;
+			}
+		}
+
+		void run()
+		{
+			std::vector<std::vector<std::string>> streams;
+			std::cout << std::left << std::setw(31) << "allocs and ns per update" << std::right;
+			for (pattern pat : { pattern::alternating, pattern::same_length, pattern::growing }) {
+				streams.push_back(stream_of(pat));
+				std::cout << std::setw(16) << pattern_names[static_cast<int>(pat)];
+			}
+			std::cout << '\n';
+			measure<setter::by_value>("by value", streams);
+			measure<setter::overload_pair>("overload pair", streams);
+			measure<setter::forward_assign>("forward assign", streams);
+		}
+	}
+
 	// Move Semantics In class Hierarchies
 	namespace sec_4_4
 	{
@@ -793,20 +1319,80 @@ namespace chapter_4
 				}
 			};
 			// http://www.cppmove.com/code/poly/polygon.hpp.html
+			// (the points are kept as x and y columns for the geometry kernels, see geometry.h)
 			class Polygon : public GeoObj {
 			protected:
-				std::vector<Coord> m_points;
+				coordbuffer::CoordBuffer<Coord> m_points;
+				// computed on first use (also by concurrent const calls), reset by every change of m_points
+				geometry::cache<double> m_area;
+				geometry::cache<double> m_perimeter;
+				geometry::cache<coordbuffer::bbox> m_bounds;
+				geometry::cache<geometry::edges> m_edges;
+
+				void invalidate() noexcept {
+					m_area.reset();
+					m_perimeter.reset();
+					m_bounds.reset();
+					m_edges.reset();
+				}
+				const geometry::edges& edges() const {
+					return m_edges.get([&] {
+						return geometry::prepare(m_points.xs(), m_points.ys(), bounds());
+					});
+				}
 			public:
 				Polygon(std::string s, std::initializer_list<Coord> pl = {})
-					: GeoObj{ std::move(s) }, m_points{ std::move(pl) }
+					: GeoObj{ std::move(s) }, m_points{ std::vector<Coord>{ pl } }
 				{}
 				virtual void draw() const override {
 					std::cout << "polygon '" << m_name << "' over";
-					for (auto& p : m_points) {
-						std::cout << " " << p;
+					for (std::size_t i = 0; i < m_points.size(); ++i) {
+						std::cout << " " << m_points[i];
 					}
 					std::cout << "\n";
 				}
+
+				std::size_t size() const {
+					return m_points.size();
+				}
+				Coord operator[] (std::size_t idx) const {
+					return m_points[idx];
+				}
+				void add_point(Coord p) {
+					m_points.push_back(p);
+					invalidate();
+				}
+				void set_point(std::size_t idx, Coord p) {
+					m_points.set(idx, p);
+					invalidate();
+				}
+				void translate(Coord d) {
+					m_points.translate(d);
+					invalidate();
+				}
+
+				double area() const {
+					return m_area.get([&] {
+						return geometry::area(m_points.xs(), m_points.ys());
+					});
+				}
+				double perimeter() const {
+					return m_perimeter.get([&] {
+						return geometry::perimeter(m_points.xs(), m_points.ys());
+					});
+				}
+				coordbuffer::bbox bounds() const {
+					return m_bounds.get([&] {
+						return m_points.bounds();
+					});
+				}
+				bool contains(Coord p) const {
+					return geometry::contains(edges(), p.getX(), p.getY());
+				}
+				// inside[i] = points[i] is inside, returns the number inside
+				std::size_t contains(const coordbuffer::CoordBuffer<Coord>& points, std::span<bool> inside) const {
+					return geometry::contains(edges(), points.xs(), points.ys(), inside);
+				}
 				//virtual ~Polygon() = default; // move semantics enabled by commenting out destructor
 				//virtual ~Polygon() = delete; // explicit deletion of destructor disables move semantics because an explicit deletion is a specification
 			};
@@ -821,5 +1407,453 @@ namespace chapter_4
 				p2.draw();
 			}
 		}
+
+		// swap, reverse and rotate by three moves vs. by relocation (see relocate.h)
+		namespace sec_4_4_2c
+		{
+			using sec_4_4_2b::Coord;
+
+			// the value part of sec_4_4_2b::Polygon (GeoObj disables assignment)
+			class Polygon {
+			private:
+				std::vector<Coord> m_points;
+			public:
+				using trivially_relocatable = relocate::all_trivially_relocatable<std::vector<Coord>>;
+
+				Polygon(std::initializer_list<Coord> pl = {})
+					: m_points{ pl }
+				{}
+			};
+
+			// swap by three moves (as chapter_2::sec_2_3_2::swap does)
+			struct three_moves {
+				template <typename T>
+				static void swap(T& a, T& b) { relocate::move_swap(a, b); }
+				template <typename It>
+				static void reverse(It first, It last) { std::reverse(first, last); }
+				template <typename It>
+				static void rotate(It first, It middle, It last) { std::rotate(first, middle, last); }
+			};
+			// swap by relocation if the elements are trivially relocatable
+			struct relocation {
+				template <typename T>
+				static void swap(T& a, T& b) { relocate::swap(a, b); }
+				template <typename It>
+				static void reverse(It first, It last) { relocate::reverse(first, last); }
+				template <typename It>
+				static void rotate(It first, It middle, It last) { relocate::rotate(first, middle, last); }
+			};
+
+			// median time per element of op on coll (performed by Engine)
+			template <typename Engine, typename T>
+			double measure(std::vector<T>& coll, const std::string& op)
+			{
+				benchmark::config cfg = benchmark::limited(10, static_cast<double>(coll.size()));
+				cfg.min_sample_time = std::min(cfg.min_sample_time, std::chrono::nanoseconds{ std::chrono::milliseconds{ 2 } });
+				auto stats = benchmark::run(op, [&] {
+					if (op == "swap") {
+						for (std::size_t i = 0; i < coll.size(); ++i) {
+							Engine::swap(coll[i], coll[i * 7919 % coll.size()]);	// scattered pairs as in partitioning
+						}
+					}
+					else if (op == "reverse") {
+						Engine::reverse(coll.begin(), coll.end());
+					}
+					else {
+						Engine::rotate(coll.begin(), coll.begin() + 3, coll.end());
+					}
+				}, cfg);
+				return stats.median / static_cast<double>(coll.size());
+			}
+
+			template <typename T, typename Make>
+			void measure(const char* type, Make make)
+			{
+				const std::size_t num = 10000;
+				std::vector<T> coll;
+				coll.reserve(num);
+				for (std::size_t i = 0; i < num; ++i) {
+					coll.push_back(make(i));
+				}
+				for (const char* op : { "swap", "reverse", "rotate" }) {
+					double moves = measure<three_moves>(coll, op);
+					double relocs = measure<relocation>(coll, op);
+					std::cout << std::left << std::setw(12) << type << std::setw(9) << op << std::right
+							  << std::setw(6) << (relocate::is_trivially_relocatable_v<T> ? "yes" : "no")
+							  << std::fixed << std::setprecision(2)
+							  << std::setw(15) << moves
+							  << std::setw(15) << relocs
+							  << std::setw(9) << moves / relocs << 'x' << '\n'
+							  << std::defaultfloat;
+				}
+			}
+
+			void run()
+			{
+				std::cout << std::left << std::setw(12) << "type" << std::setw(9) << "op" << std::right
+						  << std::setw(6) << "reloc"
+						  << std::setw(15) << "moves ns/elem"
+						  << std::setw(15) << "reloc ns/elem"
+						  << std::setw(10) << "speedup" << '\n';
+				measure<std::string>("std::string", [](std::size_t i) {
+					return std::string(32, static_cast<char>('a' + i % 26));
+				});
+				measure<chapter_3::sec_3_1::Customer>("Customer", [](std::size_t i) {
+					chapter_3::sec_3_1::Customer cust{ "customer " + std::to_string(i) };
+					for (int val : { 0, 8, 15 }) {
+						cust.add_value(val);
+					}
+					return cust;
+				});
+				measure<Polygon>("Polygon", [](std::size_t i) {
+					int n = static_cast<int>(i);
+					return Polygon{ Coord{ n, n }, Coord{ n, n + 9 }, Coord{ n + 9, n + 9 }, Coord{ n + 9, n } };
+				});
+			}
+		}
+
+		// transforming a million points: std::vector<Coord> (AoS) vs. CoordBuffer (SoA, see coordbuffer.h)
+		namespace sec_4_4_2d
+		{
+			using sec_4_4_2b::Coord;
+			using Buffer = coordbuffer::CoordBuffer<Coord>;
+
+			const Coord offset{ 3, -2 };
+
+			std::vector<Coord> make_points(std::size_t num, unsigned seed)
+			{
+				std::default_random_engine eng{ seed };
+				std::uniform_int_distribution<int> dist{ -1000, 1000 };
+				std::vector<Coord> points;
+				points.reserve(num);
+				for (std::size_t i = 0; i < num; ++i) {
+					int x = dist(eng);
+					points.emplace_back(x, dist(eng));
+				}
+				return points;
+			}
+
+			// the loops as written with the operators of Coord
+			coordbuffer::bbox aos_apply(const std::string& op, std::vector<Coord>& a, const std::vector<Coord>& b)
+			{
+				coordbuffer::bbox box;
+				if (op == "translate") {
+					for (Coord& c : a) {
+						c += offset;
+					}
+				}
+				else if (op == "negate") {
+					for (Coord& c : a) {
+						c = -c;
+					}
+				}
+				else if (op == "add") {
+					for (std::size_t i = 0; i < a.size(); ++i) {
+						a[i] += b[i];
+					}
+				}
+				else if (op == "sub") {
+					for (std::size_t i = 0; i < a.size(); ++i) {
+						a[i] -= b[i];
+					}
+				}
+				else {
+					for (const Coord& c : a) {
+						box.min_x = std::min(box.min_x, c.getX());
+						box.min_y = std::min(box.min_y, c.getY());
+						box.max_x = std::max(box.max_x, c.getX());
+						box.max_y = std::max(box.max_y, c.getY());
+					}
+				}
+				return box;
+			}
+
+			coordbuffer::bbox soa_apply(const std::string& op, Buffer& a, const Buffer& b, aggregate::isa kind)
+			{
+				coordbuffer::bbox box;
+				if (op == "translate") {
+					a.translate(offset, kind);
+				}
+				else if (op == "negate") {
+					a.negate(kind);
+				}
+				else if (op == "add") {
+					a.add(b, kind);
+				}
+				else if (op == "sub") {
+					a.sub(b, kind);
+				}
+				else {
+					box = a.bounds(kind);
+				}
+				return box;
+			}
+
+			// median time per point of func()
+			template <typename Func>
+			double measure(const std::string& op, std::size_t num, Func func)
+			{
+				benchmark::measured res = benchmark::measure(op, benchmark::limited(10, static_cast<double>(num)), [&] {
+					benchmark::do_not_optimize(func());
+				});
+				return res.time.median / static_cast<double>(num);
+			}
+
+			void run()
+			{
+				const std::size_t num = 1'000'000;
+				const char* ops[] = { "translate", "negate", "add", "sub", "bounds" };
+
+				// same results with every layout and kernel
+				bool same = true;
+				{
+					std::vector<Coord> a = make_points(num, 1);
+					std::vector<Coord> b = make_points(num, 2);
+					Buffer sa_scalar{ std::vector<Coord>{ a } };
+					Buffer sa_best{ std::vector<Coord>{ a } };
+					Buffer sb{ std::vector<Coord>{ b } };
+					for (std::string op : ops) {
+						coordbuffer::bbox box = aos_apply(op, a, b);
+						same = same && box == soa_apply(op, sa_scalar, sb, aggregate::isa::scalar)
+									&& box == soa_apply(op, sa_best, sb, aggregate::best_isa);
+					}
+					std::vector<Coord> back = std::move(sa_best).to_coords();
+					same = same && sa_best.empty() && back.size() == a.size()
+						&& std::equal(a.begin(), a.end(), back.begin(), [](Coord c1, Coord c2) {
+							return c1.getX() == c2.getX() && c1.getY() == c2.getY();
+						});
+				}
+				if (!same) {
+					throw std::runtime_error{ "SoA results differ from AoS" };
+				}
+				std::cout << num << " points, results match\n";
+
+				std::vector<Coord> a = make_points(num, 1);
+				const std::vector<Coord> b = make_points(num, 2);
+				Buffer sa{ make_points(num, 1) };
+				const Buffer sb{ make_points(num, 2) };
+
+				std::cout << std::left << std::setw(11) << "op" << std::right
+						  << std::setw(12) << "AoS ns/pt"
+						  << std::setw(12) << "SoA scalar"
+						  << std::setw(12) << "SoA " << aggregate::name(aggregate::best_isa)
+						  << std::setw(10) << "speedup" << '\n';
+				for (std::string op : ops) {
+					double aos = measure(op, num, [&] { return aos_apply(op, a, b); });
+					double scalar = measure(op, num, [&] { return soa_apply(op, sa, sb, aggregate::isa::scalar); });
+					double best = measure(op, num, [&] { return soa_apply(op, sa, sb, aggregate::best_isa); });
+					std::cout << std::left << std::setw(11) << op << std::right
+							  << std::fixed << std::setprecision(3)
+							  << std::setw(12) << aos
+							  << std::setw(12) << scalar
+							  << std::setw(16) << best
+							  << std::setprecision(2)
+							  << std::setw(9) << aos / best << 'x' << '\n'
+							  << std::defaultfloat;
+				}
+
+				// converting consumes the source: at most both layouts are alive at once
+				std::vector<Coord> points = make_points(num, 3);
+				alloccount::scope allocs;
+				auto t0 = std::chrono::steady_clock::now();
+				Buffer buf{ std::move(points) };
+				auto t1 = std::chrono::steady_clock::now();
+				points = std::move(buf).to_coords();
+				auto t2 = std::chrono::steady_clock::now();
+				std::cout << std::fixed << std::setprecision(2)
+						  << "to SoA " << std::chrono::duration<double, std::milli>{ t1 - t0 }.count() << " ms, "
+						  << "back " << std::chrono::duration<double, std::milli>{ t2 - t1 }.count() << " ms, "
+						  << alloccount::show(allocs.current().count) << " allocations, peak "
+						  << alloccount::show(static_cast<double>(allocs.current().peak) / (1024 * 1024)) << " MB\n"
+						  << std::defaultfloat;
+			}
+		}
+
+		// per frame geometry of sec_4_4_2b::Polygon: loops over std::vector<Coord> vs. the kernels of geometry.h
+		namespace sec_4_4_2e
+		{
+			using sec_4_4_2b::Coord;
+			using sec_4_4_2b::Polygon;
+
+			// the loops as written with the operators of Coord
+			double aos_area(const std::vector<Coord>& pts)
+			{
+				long long twice = 0;
+				for (std::size_t i = 0; i < pts.size(); ++i) {
+					Coord a = pts[i];
+					Coord b = pts[(i + 1) % pts.size()];
+					twice += static_cast<long long>(a.getX()) * b.getY() - static_cast<long long>(b.getX()) * a.getY();
+				}
+				return static_cast<double>(twice < 0 ? -twice : twice) / 2;
+			}
+			double aos_perimeter(const std::vector<Coord>& pts)
+			{
+				double sum = 0;
+				for (std::size_t i = 0; i < pts.size(); ++i) {
+					Coord d = pts[(i + 1) % pts.size()] - pts[i];
+					sum += std::sqrt(static_cast<double>(d.getX()) * d.getX() + static_cast<double>(d.getY()) * d.getY());
+				}
+				return sum;
+			}
+			coordbuffer::bbox aos_bounds(const std::vector<Coord>& pts)
+			{
+				coordbuffer::bbox box;
+				for (const Coord& c : pts) {
+					box.min_x = std::min(box.min_x, c.getX());
+					box.min_y = std::min(box.min_y, c.getY());
+					box.max_x = std::max(box.max_x, c.getX());
+					box.max_y = std::max(box.max_y, c.getY());
+				}
+				return box;
+			}
+			bool aos_contains(const std::vector<Coord>& pts, Coord q)
+			{
+				double x = q.getX();
+				double y = q.getY();
+				bool odd = false;
+				for (std::size_t i = 0; i < pts.size(); ++i) {
+					Coord a = pts[i];
+					Coord b = pts[(i + 1) % pts.size()];
+					if ((a.getY() > y) != (b.getY() > y)) {
+						double slope = (static_cast<double>(b.getX()) - a.getX()) / (static_cast<double>(b.getY()) - a.getY());
+						if (x < a.getX() + (y - a.getY()) * slope) {
+							odd = !odd;
+						}
+					}
+				}
+				return odd;
+			}
+			std::size_t aos_contains(const std::vector<Coord>& pts, const std::vector<Coord>& queries, std::vector<bool>& inside)
+			{
+				std::size_t hits = 0;
+				for (std::size_t i = 0; i < queries.size(); ++i) {
+					inside[i] = aos_contains(pts, queries[i]);
+					hits += inside[i];
+				}
+				return hits;
+			}
+
+			// a star with num corners (not convex, so the crossing test matters)
+			std::vector<Coord> make_star(std::size_t num)
+			{
+				std::vector<Coord> pts;
+				for (std::size_t i = 0; i < num; ++i) {
+					double angle = 2 * 3.14159265358979 * static_cast<double>(i) / static_cast<double>(num);
+					double radius = i % 2 == 0 ? 1000 : 500;
+					pts.emplace_back(static_cast<int>(std::lround(radius * std::cos(angle))),
+									 static_cast<int>(std::lround(radius * std::sin(angle))));
+				}
+				return pts;
+			}
+
+			// median time in microseconds of func()
+			template <typename Func>
+			double measure(const std::string& name, Func func)
+			{
+				benchmark::measured res = benchmark::measure(name, benchmark::limited(10), [&] {
+					benchmark::do_not_optimize(func());
+				});
+				return res.time.median / 1000;
+			}
+
+			void run()
+			{
+				const std::size_t corners = 1000;
+				const std::size_t num_queries = 10'000;
+				const std::vector<Coord> pts = make_star(corners);
+				std::vector<Coord> queries;
+				std::default_random_engine eng{ 42 };
+				std::uniform_int_distribution<int> dist{ -1200, 1200 };
+				for (std::size_t i = 0; i < num_queries; ++i) {
+					int x = dist(eng);
+					queries.emplace_back(x, dist(eng));
+				}
+
+				Polygon poly{ "star" };
+				for (Coord c : pts) {
+					poly.add_point(c);
+				}
+				const coordbuffer::CoordBuffer<Coord> soa{ std::vector<Coord>{ pts } };
+				const coordbuffer::CoordBuffer<Coord> soa_queries{ std::vector<Coord>{ queries } };
+				std::span<const int> xs = soa.xs();
+				std::span<const int> ys = soa.ys();
+				const aggregate::isa best = aggregate::best_isa;
+
+				// same results with every implementation (the perimeter up to rounding)
+				std::vector<bool> aos_inside(num_queries);
+				std::unique_ptr<bool[]> scalar_inside{ new bool[num_queries] };
+				std::unique_ptr<bool[]> best_inside{ new bool[num_queries] };
+				std::unique_ptr<bool[]> poly_inside{ new bool[num_queries] };
+				std::size_t hits = aos_contains(pts, queries, aos_inside);
+				geometry::edges edges = geometry::prepare(xs, ys, soa.bounds());
+				bool same = hits == geometry::contains(edges, soa_queries.xs(), soa_queries.ys(), { scalar_inside.get(), num_queries }, aggregate::isa::scalar)
+					&& hits == geometry::contains(edges, soa_queries.xs(), soa_queries.ys(), { best_inside.get(), num_queries }, best)
+					&& hits == poly.contains(soa_queries, { poly_inside.get(), num_queries });
+				for (std::size_t i = 0; i < num_queries; ++i) {
+					same = same && aos_inside[i] == scalar_inside[i] && aos_inside[i] == best_inside[i] && aos_inside[i] == poly_inside[i];
+				}
+				double area = aos_area(pts);
+				double perimeter = aos_perimeter(pts);
+				same = same && area == geometry::area(xs, ys, aggregate::isa::scalar) && area == geometry::area(xs, ys, best)
+					&& area == poly.area()
+					&& std::abs(perimeter - geometry::perimeter(xs, ys, best)) < perimeter * 1e-12
+					&& std::abs(perimeter - poly.perimeter()) < perimeter * 1e-12
+					&& aos_bounds(pts) == poly.bounds();
+				// the cache follows the points
+				poly.translate(Coord{ 5000, 0 });
+				same = same && poly.area() == area && poly.bounds().min_x == aos_bounds(pts).min_x + 5000
+					&& !poly.contains(Coord{ 0, 0 }) && poly.contains(Coord{ 5000, 0 });
+				poly.translate(Coord{ -5000, 0 });
+				Polygon moved{ std::move(poly) };
+				same = same && moved.area() == area && poly.area() == 0;
+				if (!same) {
+					throw std::runtime_error{ "geometry results differ from AoS" };
+				}
+				std::cout << corners << " corners, " << num_queries << " points (" << hits << " inside), results match\n";
+
+				std::cout << std::left << std::setw(10) << "op" << std::right
+						  << std::setw(12) << "AoS us"
+						  << std::setw(12) << "scalar us"
+						  << std::setw(9) << aggregate::name(best) << " us"
+						  << std::setw(12) << "cached us" << '\n';
+				auto row = [](const char* op, double aos, double scalar, double simd, double cached) {
+					std::cout << std::left << std::setw(10) << op << std::right
+							  << std::fixed << std::setprecision(3)
+							  << std::setw(12) << aos
+							  << std::setw(12) << scalar
+							  << std::setw(12) << simd
+							  << std::setw(12) << cached << '\n'
+							  << std::defaultfloat;
+				};
+				row("area",
+					measure("aos", [&] { return aos_area(pts); }),
+					measure("scalar", [&] { return geometry::area(xs, ys, aggregate::isa::scalar); }),
+					measure("simd", [&] { return geometry::area(xs, ys, best); }),
+					measure("cached", [&] { return moved.area(); }));
+				row("perimeter",
+					measure("aos", [&] { return aos_perimeter(pts); }),
+					measure("scalar", [&] { return geometry::perimeter(xs, ys, aggregate::isa::scalar); }),
+					measure("simd", [&] { return geometry::perimeter(xs, ys, best); }),
+					measure("cached", [&] { return moved.perimeter(); }));
+				row("bounds",
+					measure("aos", [&] { return aos_bounds(pts); }),
+					measure("scalar", [&] { return soa.bounds(aggregate::isa::scalar); }),
+					measure("simd", [&] { return soa.bounds(best); }),
+					measure("cached", [&] { return moved.bounds(); }));
+				// uncached: edges prepared on every call
+				row("contains",
+					measure("aos", [&] { return aos_contains(pts, queries, aos_inside); }),
+					measure("scalar", [&] {
+						return geometry::contains(geometry::prepare(xs, ys, soa.bounds()), soa_queries.xs(), soa_queries.ys(),
+												  { scalar_inside.get(), num_queries }, aggregate::isa::scalar);
+					}),
+					measure("simd", [&] {
+						return geometry::contains(geometry::prepare(xs, ys, soa.bounds()), soa_queries.xs(), soa_queries.ys(),
+												  { best_inside.get(), num_queries }, best);
+					}),
+					measure("cached", [&] { return moved.contains(soa_queries, { poly_inside.get(), num_queries }); }));
+				std::cout << "(contains: all " << num_queries << " points)\n";
+			}
+		}
 	}
 }
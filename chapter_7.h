@@ -5,29 +5,35 @@
 #include <string>
 #include <vector>
 #include <type_traits>
+#include <iomanip>
+
+#include "alloccount.h"
+#include "benchmark.h"
+#include "perfcount.h"
+#include "smfcount.h"
 
 // Move Semantics and noexcept
 namespace chapter_7
 {
 	namespace sec_7_1_1
 	{
-		class Person {
+		class Person : public smfcount::counted<Person> {
 		private:
 			std::string m_name;
 		public:
 			Person(const char* n)
 				: m_name{ n }
 			{}
-			// print out when we copy or move
+			// count (and with --trace print out) when we copy or move
 			Person(const Person& p)
-				: m_name{ p.m_name }
+				: counted{ p }, m_name{ p.m_name }
 			{
-				std::cout << "COPY: " << m_name << '\n';
+				trace("COPY: ", m_name);
 			}
 			Person(Person&& p)
-				: m_name{ std::move(p.m_name) }
+				: counted{ std::move(p) }, m_name{ std::move(p.m_name) }
 			{
-				std::cout << "MOVE: " << m_name << '\n';
+				trace("MOVE: ", m_name);
 			}
 			std::string getName() const {
 				return m_name;
@@ -48,23 +54,23 @@ namespace chapter_7
 	// declaring noexcept is significant to the definition of the move constructor
 	namespace sec_7_1_2
 	{
-		class Person {
+		class Person : public smfcount::counted<Person> {
 		private:
 			std::string m_name;
 		public:
 			Person(const char* n)
 				: m_name{ n }
 			{}
-			// print out when we copy or move
+			// count (and with --trace print out) when we copy or move
 			Person(const Person& p)
-				: m_name{ p.m_name }
+				: counted{ p }, m_name{ p.m_name }
 			{
-				std::cout << "COPY: " << m_name << '\n';
+				trace("COPY: ", m_name);
 			}
 			Person(Person&& p) noexcept
-				: m_name{ std::move(p.m_name) }
+				: counted{ std::move(p) }, m_name{ std::move(p.m_name) }
 			{
-				std::cout << "MOVE: " << m_name << '\n';
+				trace("MOVE: ", m_name);
 			}
 			std::string getName() const {
 				return m_name;
@@ -85,25 +91,25 @@ namespace chapter_7
 	// conditional noexcept declartion
 	namespace sec_7_1_2b
 	{
-		class Person {
+		class Person : public smfcount::counted<Person> {
 		private:
 			std::string m_name;
 		public:
 			Person(const char* n)
 				: m_name{ n }
 			{}
-			// print out when we copy or move
+			// count (and with --trace print out) when we copy or move
 			Person(const Person& p)
-				: m_name{ p.m_name }
+				: counted{ p }, m_name{ p.m_name }
 			{
-				std::cout << "COPY: " << m_name << '\n';
+				trace("COPY: ", m_name);
 			}
 			Person(Person&& p)
 				noexcept(std::is_nothrow_move_constructible_v<std::string>
-					&& noexcept(std::cout << m_name))
-				: m_name{ std::move(p.m_name) }
+					&& noexcept(trace("MOVE: ", m_name)))
+				: counted{ std::move(p) }, m_name{ std::move(p.m_name) }
 			{
-				std::cout << "MOVE: " << m_name << '\n';
+				trace("MOVE: ", m_name);
 			}
 			std::string getName() const {
 				return m_name;
@@ -124,18 +130,18 @@ namespace chapter_7
 	// default generated move
 	namespace sec_7_1_2c
 	{
-		class Person {
+		class Person : public smfcount::counted<Person> {
 		private:
 			std::string m_name;
 		public:
 			Person(const char* n)
 				: m_name{ n }
 			{}
-			// print out when we copy or move
+			// count (and with --trace print out) when we copy or move
 			Person(const Person& p)
-				: m_name{ p.m_name }
+				: counted{ p }, m_name{ p.m_name }
 			{
-				std::cout << "COPY: " << m_name << '\n';
+				trace("COPY: ", m_name);
 			}
 			Person(Person&& p) = default;
 
@@ -175,19 +181,171 @@ namespace chapter_7
 			{}
 		};
 
+		// measure num reallocations of 1 Million wrapped strings
+		std::chrono::nanoseconds measure(std::size_t num)
+		{
+			benchmark::stopwatch watch;		// also counts hardware events with --perf
+			for (std::size_t i = 0; i < num; ++i) {
+				// create vector of 1 Million wrapped strings
+				std::vector<Str> coll;
+				coll.resize(1000000);
+
+				// measure time to reallocate memory for all elements
+				watch.start();
+				coll.reserve(coll.capacity() + 1);
+				benchmark::do_not_optimize(coll.data());
+				watch.stop();
+			}
+			return watch.elapsed();
+		}
+
 		void run()
 		{
-			// create vector of 1 Million wrapped strings
-			std::vector<Str> coll;
-			coll.resize(1000000);
+			benchmark::config cfg{ benchmark::settings() };
+			cfg.items = 1000000;	// report hardware events per element
+			benchmark::run_manual("reserve of 1M Str", measure, cfg);
+		}
+	}
+	// Is noexcept Worth It? Sweep over element count, string length,
+	// noexcept vs. throwing move and element type (the Person variants above)
+	namespace sec_7_1_3b
+	{
+		// like Str, but with a given value and a move constructor that might throw
+		template <bool NoExcept>
+		struct BasicStr {
+			std::string val;
+
+			BasicStr(const char* v)
+				: val{ v }
+			{}
+
+			// enable copying
+			BasicStr(const BasicStr&) = default;
+
+			// enable moving (with and without noexcept)
+			BasicStr(BasicStr&& s) noexcept(NoExcept)
+				: val{ std::move(s.val) }
+			{}
+		};
+
+		struct result {
+			const char*	type;
+			std::size_t	num;			// elements
+			std::size_t	len;			// characters per string
+			bool		moves;			// reallocation moves (or copies) the elements
+			double		ns_per_elem;	// median time of the reallocation per element
+			double		bytes_per_elem;	// element and heap bytes moved or copied per element
+			perfcount::sample perf{};	// hardware events per element (with --perf)
+		};
+
+		// measure the reallocation of num elements of type T holding strings of len characters
+		template <typename T>
+		result measure(const char* type, std::size_t num, std::size_t len, const benchmark::config& cfg)
+		{
+			std::string value(len, 'a');
+			std::size_t bytes = 0;		// allocated by the last reallocation
+			benchmark::config elem_cfg{ cfg };
+			elem_cfg.items = static_cast<double>(num);
+			auto stats = benchmark::run_manual(type, [&](std::size_t iters) {
+				benchmark::stopwatch watch;
+				for (std::size_t i = 0; i < iters; ++i) {
+					std::vector<T> coll;
+					coll.reserve(num);
+					for (std::size_t j = 0; j < num; ++j) {
+						coll.emplace_back(value.c_str());
+					}
 
-			// measure time to reallocate memory for all elements
-			auto t0 = std::chrono::steady_clock::now();
-			coll.reserve(coll.capacity() + 1);
-			auto t1 = std::chrono::steady_clock::now();
+					// measure time to reallocate memory for all elements
+					alloccount::scope allocs;
+					watch.start();
+					coll.reserve(coll.capacity() + 1);
+					benchmark::do_not_optimize(coll.data());
+					watch.stop();
+					bytes = allocs.current().bytes;
+				}
+				return watch.elapsed();
+			}, elem_cfg);
 
-			std::chrono::duration<double, std::milli> d{t1 - t0};
-			std::cout << d.count() << "ms\n";
+			// the new buffer is allocated in any case, heap bytes beyond it are copied strings
+			std::size_t buffer = (num + 1) * sizeof(T);
+			std::size_t copied = bytes > buffer ? bytes - buffer : 0;
+			return result{ type, num, len, std::is_nothrow_move_constructible_v<T>,
+						   stats.median / static_cast<double>(num),
+						   static_cast<double>(num * sizeof(T) + copied) / static_cast<double>(num), stats.perf };
+		}
+
+		void print(std::ostream& strm, const result& res, bool json)
+		{
+			if (json) {
+				strm << "{\"name\":\"realloc\",\"type\":\"" << res.type << '"'
+					 << ",\"elements\":" << res.num
+					 << ",\"length\":" << res.len
+					 << ",\"moves\":" << (res.moves ? "true" : "false")
+					 << ",\"ns_per_elem\":" << res.ns_per_elem
+					 << ",\"bytes_per_elem\":" << alloccount::show(res.bytes_per_elem, true);
+				for (std::size_t i = 0; i < perfcount::num_counters; ++i) {
+					if (res.perf.valid[i]) {
+						strm << ",\"" << benchmark::perf_keys[i] << "_per_elem\":" << res.perf.values[i];
+					}
+				}
+				strm << "}\n";
+				return;
+			}
+			strm << std::left << std::setw(26) << res.type << std::right
+				 << std::setw(10) << res.num
+				 << std::setw(8) << res.len
+				 << std::setw(7) << (res.moves ? "move" : "copy")
+				 << std::fixed << std::setprecision(2)
+				 << std::setw(12) << res.ns_per_elem
+				 << std::setprecision(1)
+				 << std::setw(12) << alloccount::show(res.bytes_per_elem);
+			if (res.perf.valid[perfcount::cycles]) {
+				strm << std::setprecision(2)
+					 << std::setw(8) << res.perf.ipc()
+					 << std::setprecision(3);
+				for (std::size_t i = perfcount::l1d_misses; i < perfcount::num_counters; ++i) {
+					strm << std::setw(12) << res.perf.values[i];
+				}
+			}
+			strm << '\n' << std::defaultfloat;
+		}
+
+		void run()
+		{
+			// each sample creates all elements again, keep the sweep affordable
+			benchmark::config cfg = benchmark::limited(7);
+			cfg.warmup_samples = std::min(cfg.warmup_samples, 1);
+			cfg.min_sample_time = std::min(cfg.min_sample_time, std::chrono::nanoseconds{ std::chrono::milliseconds{ 1 } });
+
+			if (!cfg.json) {
+				std::cout << std::left << std::setw(26) << "type" << std::right
+						  << std::setw(10) << "elements"
+						  << std::setw(8) << "length"
+						  << std::setw(7) << "how"
+						  << std::setw(12) << "ns/elem"
+						  << std::setw(12) << "bytes/elem";
+				if (cfg.perf) {
+					std::cout << std::setw(8) << "IPC"
+							  << std::setw(12) << "L1d/elem"
+							  << std::setw(12) << "LLC/elem"
+							  << std::setw(12) << "brmiss/elem";
+				}
+				std::cout << '\n';
+			}
+			// string lengths below and above the SSO threshold (15 or 22 characters)
+			for (std::size_t num : { 1'000, 10'000, 100'000, 1'000'000 }) {
+				for (std::size_t len : { 8, 32, 100 }) {
+					for (const result& res : {
+							measure<BasicStr<true>>("Str noexcept", num, len, cfg),
+							measure<BasicStr<false>>("Str throwing", num, len, cfg),
+							measure<sec_7_1_1::Person>("sec_7_1_1::Person", num, len, cfg),
+							measure<sec_7_1_2::Person>("sec_7_1_2::Person", num, len, cfg),
+							measure<sec_7_1_2b::Person>("sec_7_1_2b::Person", num, len, cfg),
+							measure<sec_7_1_2c::Person>("sec_7_1_2c::Person", num, len, cfg) }) {
+						print(std::cout, res, cfg.json);
+					}
+				}
+			}
 		}
 	}
 	// Details of noexcept Declarations
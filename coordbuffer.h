@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aggregate.h"
+
+// Structure-of-arrays coordinates
+// A std::vector<Coord> (chapter_4::sec_4_4) interleaves x and y, and Coord::operator+=
+// goes through *this = *this + c for every point. CoordBuffer keeps all x and all y in
+// two separate int arrays, so the transformations are plain loops over contiguous ints
+// (AVX2 kernels if the CPU supports them, else SSE2, see aggregate.h; the bounding box
+// is aggregate::summarize() of each column):
+//
+//		coordbuffer::CoordBuffer<Coord> buf{ std::move(points) };	// points is empty afterwards
+//		buf.translate(Coord{ 10, -5 });
+//		coordbuffer::bbox box = buf.bounds();
+//		points = std::move(buf).to_coords();
+//
+// Converting takes the vector by rvalue reference and releases its memory; the values are
+// copied into the columns (an interleaved buffer can't become two columns in place).
+// Coord needs a constructor from x and y and getX()/getY().
+namespace coordbuffer
+{
+	// bounding box (min > max if there are no points)
+	struct bbox {
+		int min_x{ INT_MAX };
+		int min_y{ INT_MAX };
+		int max_x{ INT_MIN };
+		int max_y{ INT_MIN };
+
+		bool empty() const noexcept
+		{
+			return min_x > max_x;
+		}
+		friend bool operator== (const bbox&, const bbox&) = default;
+	};
+
+	namespace detail
+	{
+#if defined(AGGREGATE_AVX2)
+		// the AVX2 loops of the kernels below, return where the blocks of 8 ints end
+		AGGREGATE_TARGET_AVX2 inline std::size_t add_scalar_avx2(std::span<int> a, int b) noexcept
+		{
+			std::size_t i = 0;
+			__m256i vb = _mm256_set1_epi32(b);
+			for (; i + 8 <= a.size(); i += 8) {
+				__m256i* p = reinterpret_cast<__m256i*>(a.data() + i);
+				_mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), vb));
+			}
+			return i;
+		}
+
+		AGGREGATE_TARGET_AVX2 inline std::size_t negate_avx2(std::span<int> a) noexcept
+		{
+			std::size_t i = 0;
+			for (; i + 8 <= a.size(); i += 8) {
+				__m256i* p = reinterpret_cast<__m256i*>(a.data() + i);
+				_mm256_storeu_si256(p, _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_loadu_si256(p)));
+			}
+			return i;
+		}
+
+		template <bool Sub>
+		AGGREGATE_TARGET_AVX2 std::size_t add_pairwise_avx2(std::span<int> a, std::span<const int> b) noexcept
+		{
+			std::size_t i = 0;
+			for (; i + 8 <= a.size(); i += 8) {
+				__m256i* p = reinterpret_cast<__m256i*>(a.data() + i);
+				__m256i va = _mm256_loadu_si256(p);
+				__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + i));
+				_mm256_storeu_si256(p, Sub ? _mm256_sub_epi32(va, vb) : _mm256_add_epi32(va, vb));
+			}
+			return i;
+		}
+#endif
+
+		// a[i] += b
+		inline void add_scalar(std::span<int> a, int b, aggregate::isa kind) noexcept
+		{
+			kind = aggregate::usable(kind);
+			std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+			if (kind == aggregate::isa::avx2) {
+				i = add_scalar_avx2(a, b);
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			if (kind >= aggregate::isa::sse2) {
+				__m128i vb = _mm_set1_epi32(b);
+				for (; i + 4 <= a.size(); i += 4) {
+					__m128i* p = reinterpret_cast<__m128i*>(a.data() + i);
+					_mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), vb));
+				}
+			}
+#endif
+			for (; i < a.size(); ++i) {
+				a[i] += b;
+			}
+		}
+
+		// a[i] = -a[i]
+		inline void negate(std::span<int> a, aggregate::isa kind) noexcept
+		{
+			kind = aggregate::usable(kind);
+			std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+			if (kind == aggregate::isa::avx2) {
+				i = negate_avx2(a);
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			if (kind >= aggregate::isa::sse2) {
+				for (; i + 4 <= a.size(); i += 4) {
+					__m128i* p = reinterpret_cast<__m128i*>(a.data() + i);
+					_mm_storeu_si128(p, _mm_sub_epi32(_mm_setzero_si128(), _mm_loadu_si128(p)));
+				}
+			}
+#endif
+			for (; i < a.size(); ++i) {
+				a[i] = -a[i];
+			}
+		}
+
+		// a[i] += b[i] (or -= if Sub)
+		template <bool Sub>
+		void add_pairwise(std::span<int> a, std::span<const int> b, aggregate::isa kind) noexcept
+		{
+			kind = aggregate::usable(kind);
+			std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+			if (kind == aggregate::isa::avx2) {
+				i = add_pairwise_avx2<Sub>(a, b);
+			}
+#endif
+#if defined(AGGREGATE_SSE2)
+			if (kind >= aggregate::isa::sse2) {
+				for (; i + 4 <= a.size(); i += 4) {
+					__m128i* p = reinterpret_cast<__m128i*>(a.data() + i);
+					__m128i va = _mm_loadu_si128(p);
+					__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + i));
+					_mm_storeu_si128(p, Sub ? _mm_sub_epi32(va, vb) : _mm_add_epi32(va, vb));
+				}
+			}
+#endif
+			for (; i < a.size(); ++i) {
+				if constexpr (Sub) {
+					a[i] -= b[i];
+				}
+				else {
+					a[i] += b[i];
+				}
+			}
+		}
+	}
+
+	template <typename Coord>
+	class CoordBuffer {
+	private:
+		std::vector<int> m_x;
+		std::vector<int> m_y;
+
+		void check_size(const CoordBuffer& other) const
+		{
+			if (other.size() != size()) {
+				throw std::invalid_argument{ "buffers of different size: " + std::to_string(size()) + " and " + std::to_string(other.size()) };
+			}
+		}
+
+	public:
+		CoordBuffer() = default;
+
+		// take over the points (points is empty afterwards)
+		explicit CoordBuffer(std::vector<Coord>&& points)
+		{
+			reserve(points.size());
+			for (const Coord& c : points) {
+				push_back(c);
+			}
+			points = std::vector<Coord>{};		// release the interleaved buffer (= {} would keep the capacity)
+		}
+
+		// the points as a vector (the buffer is empty afterwards)
+		std::vector<Coord> to_coords() &&
+		{
+			std::vector<Coord> points = std::as_const(*this).to_coords();
+			m_x = std::vector<int>{};
+			m_y = std::vector<int>{};
+			return points;
+		}
+		std::vector<Coord> to_coords() const &
+		{
+			std::vector<Coord> points;
+			points.reserve(size());
+			for (std::size_t i = 0; i < size(); ++i) {
+				points.emplace_back(m_x[i], m_y[i]);
+			}
+			return points;
+		}
+
+		void reserve(std::size_t num)
+		{
+			m_x.reserve(num);
+			m_y.reserve(num);
+		}
+		void push_back(const Coord& c)
+		{
+			m_x.push_back(c.getX());
+			m_y.push_back(c.getY());
+		}
+		void clear() noexcept
+		{
+			m_x.clear();
+			m_y.clear();
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_x.size();
+		}
+		bool empty() const noexcept
+		{
+			return m_x.empty();
+		}
+		Coord operator[] (std::size_t idx) const
+		{
+			return Coord{ m_x[idx], m_y[idx] };
+		}
+		void set(std::size_t idx, const Coord& c)
+		{
+			m_x[idx] = c.getX();
+			m_y[idx] = c.getY();
+		}
+
+		// the columns
+		std::span<const int> xs() const noexcept
+		{
+			return m_x;
+		}
+		std::span<const int> ys() const noexcept
+		{
+			return m_y;
+		}
+		std::span<int> xs() noexcept
+		{
+			return m_x;
+		}
+		std::span<int> ys() noexcept
+		{
+			return m_y;
+		}
+
+		// every point += d
+		void translate(const Coord& d, aggregate::isa kind = aggregate::best_isa) noexcept
+		{
+			detail::add_scalar(m_x, d.getX(), kind);
+			detail::add_scalar(m_y, d.getY(), kind);
+		}
+		// every point = -point
+		void negate(aggregate::isa kind = aggregate::best_isa) noexcept
+		{
+			detail::negate(m_x, kind);
+			detail::negate(m_y, kind);
+		}
+		// point i += other[i] (throws std::invalid_argument if the sizes differ)
+		void add(const CoordBuffer& other, aggregate::isa kind = aggregate::best_isa)
+		{
+			check_size(other);
+			detail::add_pairwise<false>(m_x, other.m_x, kind);
+			detail::add_pairwise<false>(m_y, other.m_y, kind);
+		}
+		// point i -= other[i] (throws std::invalid_argument if the sizes differ)
+		void sub(const CoordBuffer& other, aggregate::isa kind = aggregate::best_isa)
+		{
+			check_size(other);
+			detail::add_pairwise<true>(m_x, other.m_x, kind);
+			detail::add_pairwise<true>(m_y, other.m_y, kind);
+		}
+
+		bbox bounds(aggregate::isa kind = aggregate::best_isa) const noexcept
+		{
+			aggregate::summary x = aggregate::summarize(m_x, kind);
+			aggregate::summary y = aggregate::summarize(m_y, kind);
+			return bbox{ x.min, y.min, x.max, y.max };
+		}
+	};
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+// Buffered customer formatting
+// operator<< for Customer writes every value through the iostream formatting machinery
+// (locale, flags, a virtual call per item). The writer renders customers into its own char
+// buffer with std::to_chars() and hands the stream one large write whenever the buffer
+// is full (and at the end):
+//
+//		customerfmt::writer out{ std::cout };
+//		out << cust << '\n';
+//		out.lines(coll);		// one customer per line
+//
+// The output is the same as with operator<< ("[name: 0 8 15 ]") except that stream flags
+// (width, base, ...) do not apply. The buffer lives inside the writer (Capacity bytes),
+// so formatting never allocates.
+// Customers are written through an operator<< for the writer: types whose get_name() and
+// get_values() return views (CustomerTable rows, snapshot rows) work as they are, types
+// that return copies should provide their own (see chapter_3::sec_3_1::BasicCustomer).
+namespace customerfmt
+{
+	template <std::size_t Capacity = 16 * 1024>
+	class basic_writer {
+	private:
+		static constexpr std::size_t max_int_chars = std::numeric_limits<int>::digits10 + 2;		// digits and sign
+		static_assert(Capacity >= max_int_chars);
+
+		std::ostream&	m_strm;
+		std::size_t		m_used{ 0 };
+		std::array<char, Capacity> m_buf;
+
+		// make room for n chars
+		void reserve(std::size_t n)
+		{
+			if (Capacity - m_used < n) {
+				flush();
+			}
+		}
+
+	public:
+		explicit basic_writer(std::ostream& strm)
+			: m_strm{ strm }
+		{}
+		basic_writer(const basic_writer&) = delete;
+		basic_writer& operator= (const basic_writer&) = delete;
+		~basic_writer()
+		{
+			try {
+				flush();
+			}
+			catch (...) {
+				// a stream with exceptions enabled must not terminate us
+			}
+		}
+
+		// hand the buffered chars to the stream
+		void flush()
+		{
+			if (m_used > 0) {
+				m_strm.write(m_buf.data(), static_cast<std::streamsize>(m_used));
+				m_used = 0;
+			}
+		}
+
+		basic_writer& put(char c)
+		{
+			reserve(1);
+			m_buf[m_used++] = c;
+			return *this;
+		}
+		basic_writer& text(std::string_view str)
+		{
+			if (str.size() > Capacity - m_used) {
+				flush();
+				if (str.size() > Capacity) {
+					m_strm.write(str.data(), static_cast<std::streamsize>(str.size()));
+					return *this;
+				}
+			}
+			std::memcpy(m_buf.data() + m_used, str.data(), str.size());
+			m_used += str.size();
+			return *this;
+		}
+		basic_writer& number(int val)
+		{
+			reserve(max_int_chars);
+			char* end = std::to_chars(m_buf.data() + m_used, m_buf.data() + Capacity, val).ptr;
+			m_used = static_cast<std::size_t>(end - m_buf.data());
+			return *this;
+		}
+
+		// "[name: v1 v2 ... ]" as operator<< for customers writes it
+		basic_writer& customer(std::string_view name, std::span<const int> values)
+		{
+			put('[');
+			text(name);
+			text(": ");
+			for (int val : values) {
+				number(val);
+				put(' ');
+			}
+			put(']');
+			return *this;
+		}
+
+		// every customer of coll on its own line
+		template <typename Customers>
+		basic_writer& lines(const Customers& coll)
+		{
+			for (const auto& cust : coll) {
+				*this << cust;
+				put('\n');
+			}
+			return *this;
+		}
+
+		basic_writer& operator<< (char c)
+		{
+			return put(c);
+		}
+		basic_writer& operator<< (std::string_view str)
+		{
+			return text(str);
+		}
+		basic_writer& operator<< (int val)
+		{
+			return number(val);
+		}
+	};
+
+	using writer = basic_writer<>;
+
+	// customers whose get_name() and get_values() return views
+	template <std::size_t Capacity, typename C>
+		requires requires(const C& cust) {
+			{ cust.get_name() } -> std::same_as<std::string_view>;
+			{ cust.get_values() } -> std::convertible_to<std::span<const int>>;
+		}
+	basic_writer<Capacity>& operator<< (basic_writer<Capacity>& out, const C& cust)
+	{
+		return out.customer(cust.get_name(), cust.get_values());
+	}
+}
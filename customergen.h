@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+// Parallel deterministic customer generator
+// chapter_3::sec_3_1::create_customer() keeps its engine, distribution and counter in
+// function local statics, so it can only run on one thread at a time and its output
+// depends on the order of the calls. Here every customer draws from its own counter-based
+// random stream (a pure function of seed, customer number and draw number), so customer i
+// is the same no matter which thread creates it or how many threads there are:
+//
+//		std::vector<Customer> coll = customergen::generate<Customer>(10'000'000);
+//
+// The workers fill their own pre-reserved vectors with consecutive customers, which are then
+// moved behind the first one (reserved for all customers).
+namespace customergen
+{
+	inline constexpr std::uint64_t default_seed = 0x5eed;
+
+	// SplitMix64 finalizer (a bijective 64 bit mixing function)
+	constexpr std::uint64_t mix(std::uint64_t x) noexcept
+	{
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	// random numbers of stream id: the n-th number is mix(key + n * golden ratio)
+	class stream {
+	private:
+		std::uint64_t	m_key;
+		std::uint64_t	m_counter{ 0 };
+	public:
+		constexpr stream(std::uint64_t seed, std::uint64_t id) noexcept
+			: m_key{ mix(seed ^ mix(id + 0x9e3779b97f4a7c15ULL)) }
+		{}
+
+		constexpr std::uint64_t next() noexcept
+		{
+			return mix(m_key + ++m_counter * 0x9e3779b97f4a7c15ULL);
+		}
+
+		// uniform in [lo, hi] without bias (Lemire's multiply and reject)
+		constexpr int uniform(int lo, int hi) noexcept
+		{
+			std::uint32_t range = static_cast<std::uint32_t>(hi - lo) + 1;
+			std::uint64_t m = (next() >> 32) * range;
+			if (static_cast<std::uint32_t>(m) < range) {
+				std::uint32_t threshold = (0u - range) % range;
+				while (static_cast<std::uint32_t>(m) < threshold) {
+					m = (next() >> 32) * range;
+				}
+			}
+			return lo + static_cast<int>(m >> 32);
+		}
+	};
+
+	// customer no (counted from 1) as create_customer() makes it: 10 values from 0 to 999
+	// (C needs a constructor from the name and add_value())
+	template <typename C>
+	C make_customer(std::size_t no, std::uint64_t seed = default_seed)
+	{
+		stream rnd{ seed, no };
+		C cust{ " my test customer " + std::to_string(no) };
+		for (int i = 0; i < 10; ++i) {
+			cust.add_value(rnd.uniform(0, 999));
+		}
+		return cust;
+	}
+
+	// customers 1..num made by threads workers (0: one per hardware thread)
+	template <typename C>
+	std::vector<C> generate(std::size_t num, unsigned threads = 0, std::uint64_t seed = default_seed)
+	{
+		if (threads == 0) {
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		std::size_t parts = std::max<std::size_t>(std::min<std::size_t>(threads, num), 1);
+
+		std::vector<std::vector<C>> chunks(parts);
+		parallel::parallel_for(parts, [&](std::size_t part) {
+			std::size_t first = num * part / parts;
+			std::size_t last = num * (part + 1) / parts;
+			chunks[part].reserve(part == 0 ? num : last - first);	// the first chunk becomes the result
+			for (std::size_t i = first; i < last; ++i) {
+				chunks[part].push_back(make_customer<C>(i + 1, seed));
+			}
+		});
+
+		std::vector<C> res = std::move(chunks[0]);
+		for (std::size_t part = 1; part < parts; ++part) {
+			std::move(chunks[part].begin(), chunks[part].end(), std::back_inserter(res));
+		}
+		return res;
+	}
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Columnar customer table
+// A std::vector<Customer> (chapter_3::sec_3_1) owns two heap blocks per customer,
+// one for the name and one for the values. The table stores the same data in columns:
+//
+//		m_names		"Mozart" "Bach" "Haydn" ...		one character arena
+//		m_name_end	6 10 15 ...						end of each name in the arena
+//		m_values	0 8 15 | 3 4 | 7 7 7 ...		one int buffer
+//		m_ranges	{0,3,4} {4,2,2} ...				offset, size and capacity per customer
+//
+// so a million customers are four allocations and whole table scans read contiguous memory.
+// Rows are views with the interface of Customer (get_name() returns a string_view).
+// add_value() appends in place while the range of the customer has capacity or is the last
+// one, otherwise the range moves to the end of the value buffer (doubling its capacity)
+// and leaves a hole;
+// compact() closes the holes, all_values() requires a compact table (and throws otherwise).
+namespace customertable
+{
+	class CustomerTable {
+	private:
+		struct range {
+			std::size_t		offset{ 0 };	// first value in m_values
+			std::uint32_t	size{ 0 };
+			std::uint32_t	capacity{ 0 };
+		};
+
+		std::string			m_names;
+		std::vector<std::size_t> m_name_end;
+		std::vector<int>	m_values;
+		std::vector<range>	m_ranges;
+		std::size_t			m_holes{ 0 };	// values in m_values that belong to no customer
+		bool				m_compact{ true };	// no range has moved since the last compact()
+
+		// make room for one more value of customer idx
+		void grow(std::size_t idx)
+		{
+			range& r = m_ranges[idx];
+			if (r.size < r.capacity) {
+				return;
+			}
+			if (r.offset + r.capacity == m_values.size()) {
+				// the range is the last one in the buffer: extend it in place
+				// (the buffer grows geometrically, so appending to the last customer stays compact)
+				m_values.push_back(0);
+				++r.capacity;
+				return;
+			}
+			std::uint32_t capacity = r.capacity > 0 ? 2 * r.capacity : 1;
+			std::size_t offset = m_values.size();
+			m_values.resize(offset + capacity);
+			std::copy(m_values.begin() + static_cast<std::ptrdiff_t>(r.offset),
+					  m_values.begin() + static_cast<std::ptrdiff_t>(r.offset + r.size),
+					  m_values.begin() + static_cast<std::ptrdiff_t>(offset));
+			m_holes += r.capacity;
+			m_compact = false;		// out of row order, with spare capacity
+			r.offset = offset;
+			r.capacity = capacity;
+		}
+
+	public:
+		template <bool Const>
+		class basic_row {
+		private:
+			using table_type = std::conditional_t<Const, const CustomerTable, CustomerTable>;
+			table_type*	m_table;
+			std::size_t	m_idx;
+		public:
+			basic_row(table_type& table, std::size_t idx)
+				: m_table{ &table }, m_idx{ idx }
+			{}
+			operator basic_row<true>() const requires (!Const)
+			{
+				return { *m_table, m_idx };
+			}
+
+			std::string_view get_name() const
+			{
+				return m_table->name(m_idx);
+			}
+			std::span<const int> get_values() const
+			{
+				return m_table->values(m_idx);
+			}
+			void add_value(int val) requires (!Const)
+			{
+				m_table->add_value(m_idx, val);
+			}
+			std::size_t index() const
+			{
+				return m_idx;
+			}
+
+			friend std::ostream& operator<< (std::ostream& strm, const basic_row& row)
+			{
+				strm << '[' << row.get_name() << ": ";
+				for (int val : row.get_values()) {
+					strm << val << ' ';
+				}
+				strm << ']';
+				return strm;
+			}
+		};
+		using row = basic_row<false>;
+		using const_row = basic_row<true>;
+
+		CustomerTable() = default;
+
+		// copy the data of all customers (anything with get_name() and get_values()) into columns
+		template <typename Customers>
+		explicit CustomerTable(const Customers& coll)
+		{
+			std::size_t chars = 0;
+			std::size_t values = 0;
+			for (const auto& cust : coll) {
+				chars += std::string_view{ cust.get_name() }.size();
+				values += std::size(cust.get_values());
+			}
+			reserve(std::size(coll), chars, values);
+			for (const auto& cust : coll) {
+				add(cust.get_name(), cust.get_values());
+			}
+		}
+
+		void reserve(std::size_t customers, std::size_t chars, std::size_t values)
+		{
+			m_names.reserve(chars);
+			m_name_end.reserve(customers);
+			m_ranges.reserve(customers);
+			m_values.reserve(values);
+		}
+
+		// append a customer, returns its index
+		std::size_t add(std::string_view name, std::span<const int> values = {})
+		{
+			assert(!name.empty());
+			m_names.append(name);
+			m_name_end.push_back(m_names.size());
+			range r{ m_values.size(), static_cast<std::uint32_t>(values.size()), static_cast<std::uint32_t>(values.size()) };
+			m_values.insert(m_values.end(), values.begin(), values.end());
+			m_ranges.push_back(r);
+			return m_ranges.size() - 1;
+		}
+
+		void add_value(std::size_t idx, int val)
+		{
+			grow(idx);
+			range& r = m_ranges[idx];
+			m_values[r.offset + r.size++] = val;
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_ranges.size();
+		}
+		bool empty() const noexcept
+		{
+			return m_ranges.empty();
+		}
+
+		std::string_view name(std::size_t idx) const
+		{
+			std::size_t begin = idx > 0 ? m_name_end[idx - 1] : 0;
+			return std::string_view{ m_names }.substr(begin, m_name_end[idx] - begin);
+		}
+		std::span<const int> values(std::size_t idx) const
+		{
+			const range& r = m_ranges[idx];
+			return { m_values.data() + r.offset, r.size };
+		}
+
+		row operator[] (std::size_t idx)
+		{
+			return { *this, idx };
+		}
+		const_row operator[] (std::size_t idx) const
+		{
+			return { *this, idx };
+		}
+
+		// the values of all customers in row order
+		// (throws std::logic_error unless the table is compact, see compact())
+		std::span<const int> all_values() const
+		{
+			if (!m_compact) {
+				throw std::logic_error{ "CustomerTable::all_values() of a table with holes (call compact() first)" };
+			}
+			return { m_values.data(), m_values.size() };
+		}
+		// all values lie back to back in row order without spare capacity
+		bool compact_values() const noexcept
+		{
+			return m_compact;
+		}
+
+		// close the holes and drop the spare capacity of all ranges (one allocation)
+		void compact()
+		{
+			if (compact_values()) {
+				return;
+			}
+			std::vector<int> values;
+			values.reserve(m_values.size() - m_holes);
+			for (range& r : m_ranges) {
+				std::size_t offset = values.size();
+				values.insert(values.end(), m_values.begin() + static_cast<std::ptrdiff_t>(r.offset),
+							  m_values.begin() + static_cast<std::ptrdiff_t>(r.offset + r.size));
+				r = range{ offset, r.size, r.size };
+			}
+			m_values = std::move(values);
+			m_holes = 0;
+			m_compact = true;
+		}
+
+		// bytes of the columns (including spare capacity)
+		std::size_t memory_usage() const noexcept
+		{
+			return m_names.capacity() + m_name_end.capacity() * sizeof(std::size_t)
+				+ m_values.capacity() * sizeof(int) + m_ranges.capacity() * sizeof(range);
+		}
+
+		// owning objects again (C needs a constructor from the name and add_value())
+		template <typename C>
+		std::vector<C> to_customers() const
+		{
+			std::vector<C> res;
+			res.reserve(size());
+			for (std::size_t i = 0; i < size(); ++i) {
+				C cust{ std::string{ name(i) } };
+				for (int val : values(i)) {
+					cust.add_value(val);
+				}
+				res.push_back(std::move(cust));
+			}
+			return res;
+		}
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Constrained forwarding initialization of members
+// Covering const std::string&, std::string&& and const char* for every string member
+// by overloads takes 3^N constructors (9 for chapter_4::sec_4_3_4::Person). One
+// constructor template with forwarding references builds every member straight from its
+// argument instead: literals are converted in place (no temporary std::string), rvalues
+// are moved and lvalues copied. The concept keeps the template from accepting arguments
+// the member can't be built from (and from hijacking the copy constructor):
+//
+//		template <fwdinit::arg_for<std::string, Person> F, fwdinit::arg_for<std::string, Person> L>
+//		Person(F&& f, L&& l)
+//			: m_first{ std::forward<F>(f) }, m_last{ std::forward<L>(l) }
+//		{}
+//
+// For records with many members, record<Members...> holds them and has that constructor
+// for all of them at once (the members live in a tuple, accessed by index):
+//
+//		class Address : public fwdinit::record<std::string, std::string, std::string> {
+//		public:
+//			using record::record;
+//			const std::string& city() const { return get<1>(); }
+//		};
+//		Address a{ "Main Street 1", city, std::move(zip) };	// one copy, one move, one conversion
+namespace fwdinit
+{
+	// Arg can initialize a Member (explicitly, e.g. std::string from std::string_view)
+	// and is not a Class (so copying a Class still uses its copy constructor)
+	template <typename Arg, typename Member, typename Class = void>
+	concept arg_for = std::constructible_from<Member, Arg>
+		&& !std::derived_from<std::remove_cvref_t<Arg>, Class>;
+
+	template <typename... Members>
+	class record {
+	private:
+		std::tuple<Members...> m_members;
+
+	public:
+		// one argument per member, each member built from its argument only
+		template <typename... Args>
+			requires (sizeof...(Args) == sizeof...(Members)) && (arg_for<Args, Members, record> && ...)
+		record(Args&&... args)
+			: m_members{ std::forward<Args>(args)... }
+		{}
+
+		static constexpr std::size_t size() noexcept
+		{
+			return sizeof...(Members);
+		}
+
+		template <std::size_t I>
+		auto& get() noexcept
+		{
+			return std::get<I>(m_members);
+		}
+		template <std::size_t I>
+		const auto& get() const noexcept
+		{
+			return std::get<I>(m_members);
+		}
+
+		friend bool operator== (const record&, const record&) = default;
+	};
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "aggregate.h"
+#include "coordbuffer.h"
+
+// Polygon geometry kernels
+// Area (shoelace formula), perimeter and point-in-polygon tests over the x and y columns
+// of a polygon (e.g. CoordBuffer::xs() and ys(), the vertices in order, the last one
+// connected to the first):
+//
+//		double a = geometry::area(pts.xs(), pts.ys());
+//		geometry::edges e = geometry::prepare(pts.xs(), pts.ys(), pts.bounds());
+//		std::size_t hits = geometry::contains(e, queries.xs(), queries.ys(), inside);
+//
+// prepare() turns the polygon into the edges a horizontal ray can cross, with the slope
+// already divided out, so that testing a point costs a compare and a multiply-add per
+// edge; contains() tests 4 (AVX2) or 2 (SSE2) points against each edge at once and skips
+// points outside the bounding box. AVX2 is used if the CPU supports it (see aggregate.h).
+// Points on an edge may be reported inside or outside (crossing number rule), but all
+// ISAs report the same.
+// The area is exact (64 bit products; AVX2 only, SSE2 has no signed 32 bit multiply);
+// the perimeter sums in a different order with SIMD and may differ in the last bits.
+//
+// cache<T> holds a value derived from the members of an object, computed on first use:
+//
+//		geometry::cache<double> m_area;
+//		double area() const { return m_area.get([&] { return geometry::area(...); }); }
+//		void add_point(Coord p) { m_points.push_back(p); m_area.reset(); }
+namespace geometry
+{
+	// a polygon edge that is not horizontal, from (x1, y1) to (x1 + (y2 - y1) * slope, y2)
+	struct edge {
+		double x1;
+		double y1;
+		double y2;
+		double slope;		// dx/dy
+	};
+
+	// the edges of a polygon and its bounding box
+	struct edges {
+		std::vector<edge>	list;
+		coordbuffer::bbox	box;
+	};
+
+	// the polygon as edges (horizontal edges never cross a horizontal ray and are dropped)
+	inline edges prepare(std::span<const int> xs, std::span<const int> ys, const coordbuffer::bbox& box)
+	{
+		assert(xs.size() == ys.size());
+		edges res;
+		res.box = box;
+		res.list.reserve(xs.size());
+		for (std::size_t i = 0; i < xs.size(); ++i) {
+			std::size_t j = i + 1 == xs.size() ? 0 : i + 1;
+			if (ys[i] != ys[j]) {
+				double x1 = xs[i];
+				double y1 = ys[i];
+				double y2 = ys[j];
+				res.list.push_back(edge{ x1, y1, y2, (xs[j] - x1) / (y2 - y1) });
+			}
+		}
+		return res;
+	}
+
+	namespace detail
+	{
+		inline bool in_box(const coordbuffer::bbox& box, int x, int y) noexcept
+		{
+			return x >= box.min_x && x <= box.max_x && y >= box.min_y && y <= box.max_y;
+		}
+
+		// crossing number test of one point
+		inline bool contains_one(const edges& e, int xi, int yi) noexcept
+		{
+			if (!in_box(e.box, xi, yi)) {
+				return false;
+			}
+			double x = xi;
+			double y = yi;
+			bool odd = false;
+			for (const edge& ed : e.list) {
+				if ((ed.y1 > y) != (ed.y2 > y) && x < ed.x1 + (y - ed.y1) * ed.slope) {
+					odd = !odd;
+				}
+			}
+			return odd;
+		}
+
+#if defined(AGGREGATE_AVX2)
+		// the AVX2 loops of the functions below, return where the blocks of 4 points end
+
+		AGGREGATE_TARGET_AVX2 inline __m256i load_epi64(const int* p) noexcept
+		{
+			return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		}
+
+		AGGREGATE_TARGET_AVX2 inline __m256d load_pd(const int* p) noexcept
+		{
+			return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		}
+
+		AGGREGATE_TARGET_AVX2 inline std::size_t twice_area_avx2(std::span<const int> xs, std::span<const int> ys, long long& sum) noexcept
+		{
+			std::size_t i = 0;
+			__m256i acc = _mm256_setzero_si256();
+			for (; i + 5 <= xs.size(); i += 4) {
+				__m256i x0 = load_epi64(xs.data() + i);
+				__m256i y0 = load_epi64(ys.data() + i);
+				__m256i x1 = load_epi64(xs.data() + i + 1);
+				__m256i y1 = load_epi64(ys.data() + i + 1);
+				acc = _mm256_add_epi64(acc, _mm256_sub_epi64(_mm256_mul_epi32(x0, y1), _mm256_mul_epi32(x1, y0)));
+			}
+			alignas(32) long long sums[4];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(sums), acc);
+			sum += sums[0] + sums[1] + sums[2] + sums[3];
+			return i;
+		}
+
+		AGGREGATE_TARGET_AVX2 inline std::size_t perimeter_avx2(std::span<const int> xs, std::span<const int> ys, double& sum) noexcept
+		{
+			std::size_t i = 0;
+			__m256d acc = _mm256_setzero_pd();
+			for (; i + 5 <= xs.size(); i += 4) {
+				__m256d dx = _mm256_sub_pd(load_pd(xs.data() + i + 1), load_pd(xs.data() + i));
+				__m256d dy = _mm256_sub_pd(load_pd(ys.data() + i + 1), load_pd(ys.data() + i));
+				acc = _mm256_add_pd(acc, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+			}
+			alignas(32) double sums[4];
+			_mm256_store_pd(sums, acc);
+			sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+			return i;
+		}
+
+		AGGREGATE_TARGET_AVX2 inline std::size_t contains_avx2(const edges& e, std::span<const int> xs, std::span<const int> ys,
+															  std::span<bool> inside, std::size_t& hits) noexcept
+		{
+			std::size_t i = 0;
+			__m256d min_x = _mm256_set1_pd(e.box.min_x);
+			__m256d max_x = _mm256_set1_pd(e.box.max_x);
+			__m256d min_y = _mm256_set1_pd(e.box.min_y);
+			__m256d max_y = _mm256_set1_pd(e.box.max_y);
+			for (; i + 4 <= xs.size(); i += 4) {
+				__m256d x = load_pd(xs.data() + i);
+				__m256d y = load_pd(ys.data() + i);
+				__m256d in_box = _mm256_and_pd(
+					_mm256_and_pd(_mm256_cmp_pd(x, min_x, _CMP_GE_OQ), _mm256_cmp_pd(x, max_x, _CMP_LE_OQ)),
+					_mm256_and_pd(_mm256_cmp_pd(y, min_y, _CMP_GE_OQ), _mm256_cmp_pd(y, max_y, _CMP_LE_OQ)));
+				__m256d odd = _mm256_setzero_pd();
+				if (_mm256_movemask_pd(in_box) != 0) {
+					for (const edge& ed : e.list) {
+						__m256d y1 = _mm256_set1_pd(ed.y1);
+						__m256d crosses = _mm256_xor_pd(_mm256_cmp_pd(y1, y, _CMP_GT_OQ),
+														_mm256_cmp_pd(_mm256_set1_pd(ed.y2), y, _CMP_GT_OQ));
+						__m256d x_cross = _mm256_add_pd(_mm256_set1_pd(ed.x1),
+														_mm256_mul_pd(_mm256_sub_pd(y, y1), _mm256_set1_pd(ed.slope)));
+						odd = _mm256_xor_pd(odd, _mm256_and_pd(crosses, _mm256_cmp_pd(x, x_cross, _CMP_LT_OQ)));
+					}
+				}
+				unsigned bits = static_cast<unsigned>(_mm256_movemask_pd(_mm256_and_pd(odd, in_box)));
+				for (std::size_t k = 0; k < 4; ++k) {
+					inside[i + k] = (bits >> k) & 1;
+				}
+				hits += static_cast<std::size_t>(std::popcount(bits));
+			}
+			return i;
+		}
+#endif
+	}
+
+	// twice the signed area (positive if the vertices are counterclockwise)
+	inline long long twice_area(std::span<const int> xs, std::span<const int> ys, [[maybe_unused]] aggregate::isa kind = aggregate::best_isa) noexcept
+	{
+		assert(xs.size() == ys.size());
+		const std::size_t num = xs.size();
+		long long sum = 0;
+		std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+		if (aggregate::usable(kind) == aggregate::isa::avx2) {
+			i = detail::twice_area_avx2(xs, ys, sum);
+		}
+#endif
+		for (; i < num; ++i) {
+			std::size_t j = i + 1 == num ? 0 : i + 1;
+			sum += static_cast<long long>(xs[i]) * ys[j] - static_cast<long long>(xs[j]) * ys[i];
+		}
+		return sum;
+	}
+
+	inline double area(std::span<const int> xs, std::span<const int> ys, aggregate::isa kind = aggregate::best_isa) noexcept
+	{
+		long long twice = twice_area(xs, ys, kind);
+		return static_cast<double>(twice < 0 ? -twice : twice) / 2;
+	}
+
+	inline double perimeter(std::span<const int> xs, std::span<const int> ys, aggregate::isa kind = aggregate::best_isa) noexcept
+	{
+		assert(xs.size() == ys.size());
+		kind = aggregate::usable(kind);
+		const std::size_t num = xs.size();
+		double sum = 0;
+		std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+		if (kind == aggregate::isa::avx2) {
+			i = detail::perimeter_avx2(xs, ys, sum);
+		}
+#endif
+#if defined(AGGREGATE_SSE2)
+		if (kind >= aggregate::isa::sse2) {
+			auto load = [](const int* p) {
+				return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+			};
+			__m128d acc = _mm_setzero_pd();
+			for (; i + 3 <= num; i += 2) {
+				__m128d dx = _mm_sub_pd(load(xs.data() + i + 1), load(xs.data() + i));
+				__m128d dy = _mm_sub_pd(load(ys.data() + i + 1), load(ys.data() + i));
+				acc = _mm_add_pd(acc, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+			}
+			alignas(16) double sums[2];
+			_mm_store_pd(sums, acc);
+			sum += sums[0] + sums[1];
+		}
+#endif
+		for (; i < num; ++i) {
+			std::size_t j = i + 1 == num ? 0 : i + 1;
+			double dx = static_cast<double>(xs[j]) - xs[i];
+			double dy = static_cast<double>(ys[j]) - ys[i];
+			sum += std::sqrt(dx * dx + dy * dy);
+		}
+		return sum;
+	}
+
+	// inside[i] = point (xs[i], ys[i]) is inside the polygon, returns the number inside
+	inline std::size_t contains(const edges& e, std::span<const int> xs, std::span<const int> ys,
+								std::span<bool> inside, aggregate::isa kind = aggregate::best_isa) noexcept
+	{
+		assert(xs.size() == ys.size() && inside.size() >= xs.size());
+		kind = aggregate::usable(kind);
+		const std::size_t num = xs.size();
+		std::size_t hits = 0;
+		std::size_t i = 0;
+#if defined(AGGREGATE_AVX2)
+		if (kind == aggregate::isa::avx2) {
+			i = detail::contains_avx2(e, xs, ys, inside, hits);
+		}
+#endif
+#if defined(AGGREGATE_SSE2)
+		if (kind >= aggregate::isa::sse2) {
+			auto load = [](const int* p) {
+				return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+			};
+			__m128d min_x = _mm_set1_pd(e.box.min_x);
+			__m128d max_x = _mm_set1_pd(e.box.max_x);
+			__m128d min_y = _mm_set1_pd(e.box.min_y);
+			__m128d max_y = _mm_set1_pd(e.box.max_y);
+			for (; i + 2 <= num; i += 2) {
+				__m128d x = load(xs.data() + i);
+				__m128d y = load(ys.data() + i);
+				__m128d in_box = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(x, min_x), _mm_cmple_pd(x, max_x)),
+											_mm_and_pd(_mm_cmpge_pd(y, min_y), _mm_cmple_pd(y, max_y)));
+				__m128d odd = _mm_setzero_pd();
+				if (_mm_movemask_pd(in_box) != 0) {
+					for (const edge& ed : e.list) {
+						__m128d y1 = _mm_set1_pd(ed.y1);
+						__m128d crosses = _mm_xor_pd(_mm_cmpgt_pd(y1, y), _mm_cmpgt_pd(_mm_set1_pd(ed.y2), y));
+						__m128d x_cross = _mm_add_pd(_mm_set1_pd(ed.x1), _mm_mul_pd(_mm_sub_pd(y, y1), _mm_set1_pd(ed.slope)));
+						odd = _mm_xor_pd(odd, _mm_and_pd(crosses, _mm_cmplt_pd(x, x_cross)));
+					}
+				}
+				unsigned bits = static_cast<unsigned>(_mm_movemask_pd(_mm_and_pd(odd, in_box)));
+				inside[i] = bits & 1;
+				inside[i + 1] = (bits >> 1) & 1;
+				hits += static_cast<std::size_t>(std::popcount(bits));
+			}
+		}
+#endif
+		for (; i < num; ++i) {
+			inside[i] = detail::contains_one(e, xs[i], ys[i]);
+			hits += inside[i];
+		}
+		return hits;
+	}
+
+	inline bool contains(const edges& e, int x, int y) noexcept
+	{
+		return detail::contains_one(e, x, y);
+	}
+
+	// a value computed from other members on first use, until reset()
+	// Like a const member function, get() may be called by several threads at once (the
+	// first computes, the others wait for it); reset() needs exclusive access like any
+	// other change of the object.
+	// (moving takes the value along: the moved-from object has lost what it was computed from)
+	template <typename T>
+	class cache {
+	private:
+		mutable std::mutex			m_compute;			// serializes the first computation
+		mutable std::atomic<bool>	m_ready{ false };
+		mutable std::optional<T>	m_value;
+
+	public:
+		cache() = default;
+		cache(const cache& c)
+		{
+			std::lock_guard<std::mutex> lock{ c.m_compute };
+			if (c.m_ready.load(std::memory_order_relaxed)) {
+				m_value = c.m_value;
+				m_ready.store(true, std::memory_order_relaxed);
+			}
+		}
+		cache(cache&& c) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (c.m_ready.load(std::memory_order_relaxed)) {
+				m_value = std::move(c.m_value);
+				m_ready.store(true, std::memory_order_relaxed);
+				c.reset();
+			}
+		}
+		cache& operator= (const cache& c)
+		{
+			if (this != &c) {
+				cache tmp{ c };
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		cache& operator= (cache&& c) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (this != &c) {
+				reset();
+				if (c.m_ready.load(std::memory_order_relaxed)) {
+					m_value = std::move(c.m_value);
+					m_ready.store(true, std::memory_order_relaxed);
+					c.reset();
+				}
+			}
+			return *this;
+		}
+
+		template <typename Compute>
+		const T& get(Compute compute) const
+		{
+			if (!m_ready.load(std::memory_order_acquire)) {
+				std::lock_guard<std::mutex> lock{ m_compute };
+				if (!m_ready.load(std::memory_order_relaxed)) {
+					m_value.emplace(compute());
+					m_ready.store(true, std::memory_order_release);
+				}
+			}
+			return *m_value;
+		}
+		bool has_value() const noexcept
+		{
+			return m_ready.load(std::memory_order_acquire);
+		}
+		void reset() noexcept
+		{
+			m_ready.store(false, std::memory_order_relaxed);
+			m_value.reset();
+		}
+	};
+}
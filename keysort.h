@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+// Key-caching sort
+// Sorting with a comparator like
+//
+//		[](const Customer& c1, const Customer& c2) { return c1.get_name() < c2.get_name(); }
+//
+// computes two keys per comparison (two string copies if get_name() returns by value) and
+// moves the elements around with every swap. sort_by_key() computes every key once, sorts
+// (key, index) pairs instead of the elements and finally moves every element at most twice
+// to its place (following the cycles of the permutation):
+//
+//		keysort::sort_by_key(coll, [](const Customer& c) { return c.get_name(); });
+//
+// parallel_sort_by_key() also extracts the keys and sorts the pairs on several threads
+// (sorting chunks, then merging them pairwise in parallel rounds).
+// Both sorts are stable.
+namespace keysort
+{
+	namespace detail
+	{
+		template <typename T, typename KeyFunc>
+		using key_type = std::decay_t<std::invoke_result_t<KeyFunc&, const T&>>;
+
+		// move the elements of coll so that coll[i] becomes the old coll[order[i]] (destroys order)
+		template <typename T>
+		void permute(std::vector<T>& coll, std::vector<std::size_t>& order)
+		{
+			for (std::size_t start = 0; start < coll.size(); ++start) {
+				if (order[start] == start) {
+					continue;		// in place or cycle done already
+				}
+				T tmp{ std::move(coll[start]) };
+				std::size_t pos = start;
+				while (order[pos] != start) {
+					std::size_t next = order[pos];
+					coll[pos] = std::move(coll[next]);
+					order[pos] = pos;
+					pos = next;
+				}
+				coll[pos] = std::move(tmp);
+				order[pos] = pos;
+			}
+		}
+
+		template <typename Key, typename Compare>
+		struct pair_less {
+			Compare comp;
+			bool operator() (const std::pair<Key, std::size_t>& a, const std::pair<Key, std::size_t>& b) const
+			{
+				if (comp(a.first, b.first)) {
+					return true;
+				}
+				if (comp(b.first, a.first)) {
+					return false;
+				}
+				return a.second < b.second;		// keep equal keys in their order
+			}
+		};
+
+		// the old indexes of the sorted pairs
+		template <typename Key>
+		std::vector<std::size_t> order_of(std::vector<std::pair<Key, std::size_t>>& keyed)
+		{
+			std::vector<std::size_t> order;
+			order.reserve(keyed.size());
+			for (auto& kv : keyed) {
+				order.push_back(kv.second);
+			}
+			return order;
+		}
+	}
+
+	// sort coll by key(elem) with comp, computing every key once
+	template <typename T, typename KeyFunc, typename Compare = std::less<>>
+	void sort_by_key(std::vector<T>& coll, KeyFunc key, Compare comp = {})
+	{
+		using Key = detail::key_type<T, KeyFunc>;
+		std::vector<std::pair<Key, std::size_t>> keyed;
+		keyed.reserve(coll.size());
+		for (std::size_t i = 0; i < coll.size(); ++i) {
+			keyed.emplace_back(key(coll[i]), i);
+		}
+		std::sort(keyed.begin(), keyed.end(), detail::pair_less<Key, Compare>{ comp });
+		std::vector<std::size_t> order = detail::order_of(keyed);
+		keyed = decltype(keyed){};		// release the keys before moving the elements (= {} would keep the capacity)
+		detail::permute(coll, order);
+	}
+
+	// the same with threads workers (0: one per hardware thread)
+	template <typename T, typename KeyFunc, typename Compare = std::less<>>
+	void parallel_sort_by_key(std::vector<T>& coll, KeyFunc key, unsigned threads = 0, Compare comp = {})
+	{
+		using Key = detail::key_type<T, KeyFunc>;
+		using pair = std::pair<Key, std::size_t>;
+		constexpr std::size_t min_chunk = 4096;		// not worth a thread below
+		if (threads == 0) {
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		std::size_t parts = std::clamp<std::size_t>(coll.size() / min_chunk, 1, threads);
+		if (parts == 1) {
+			sort_by_key(coll, key, comp);
+			return;
+		}
+		auto bound = [&](std::size_t part) {
+			return coll.size() * part / parts;
+		};
+
+		// extract the keys and sort them chunk by chunk
+		std::vector<pair> keyed(coll.size());
+		detail::pair_less<Key, Compare> less{ comp };
+		parallel::parallel_for(parts, [&](std::size_t part) {
+			for (std::size_t i = bound(part); i < bound(part + 1); ++i) {
+				keyed[i] = pair{ key(coll[i]), i };
+			}
+			std::sort(keyed.begin() + static_cast<std::ptrdiff_t>(bound(part)),
+					  keyed.begin() + static_cast<std::ptrdiff_t>(bound(part + 1)), less);
+		});
+
+		// merge neighboring runs in rounds (moving the pairs between two buffers)
+		std::vector<std::size_t> runs;
+		for (std::size_t part = 0; part <= parts; ++part) {
+			runs.push_back(bound(part));
+		}
+		std::vector<pair> buffer(coll.size());
+		while (runs.size() > 2) {
+			std::size_t merges = (runs.size() - 1) / 2;
+			parallel::parallel_for(merges, [&](std::size_t m) {
+				auto first = keyed.begin() + static_cast<std::ptrdiff_t>(runs[2 * m]);
+				auto middle = keyed.begin() + static_cast<std::ptrdiff_t>(runs[2 * m + 1]);
+				auto last = keyed.begin() + static_cast<std::ptrdiff_t>(runs[2 * m + 2]);
+				std::merge(std::make_move_iterator(first), std::make_move_iterator(middle),
+						   std::make_move_iterator(middle), std::make_move_iterator(last),
+						   buffer.begin() + static_cast<std::ptrdiff_t>(runs[2 * m]), less);
+			});
+			if ((runs.size() - 1) % 2 != 0) {
+				// an odd run left over is moved as is
+				std::move(keyed.begin() + static_cast<std::ptrdiff_t>(runs[runs.size() - 2]), keyed.end(),
+						  buffer.begin() + static_cast<std::ptrdiff_t>(runs[runs.size() - 2]));
+			}
+			std::vector<std::size_t> merged;
+			for (std::size_t i = 0; i < runs.size(); i += 2) {
+				merged.push_back(runs[i]);
+			}
+			if (merged.back() != runs.back()) {
+				merged.push_back(runs.back());
+			}
+			runs = std::move(merged);
+			keyed.swap(buffer);
+		}
+		buffer = decltype(buffer){};
+
+		std::vector<std::size_t> order = detail::order_of(keyed);
+		keyed = decltype(keyed){};
+		detail::permute(coll, order);
+	}
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+
+// Zero-copy line ingestion
+// Instead of reading every line into a std::string and moving it into a vector
+// (one heap allocation per line that does not fit into the SSO buffer), the whole input
+// is memory-mapped (or, for pipes, read into one buffer) and the lines are string_views
+// into it. Loading a file of any size allocates the line vector and nothing else:
+//
+//		linereader::lines rows = linereader::lines::from_file("server.log");
+//		for (std::string_view row : rows) { ... }
+//		std::vector<std::string> owned = rows.materialize();	// only if strings are needed
+//
+// Lines are split like std::getline() does: at '\n', without it, and a last line without
+// a newline still counts. Failures to open or map a file throw std::system_error.
+// Large inputs can be materialized by several threads (see split_parallel()).
+namespace linereader
+{
+	// the bytes of the input, either mapped or owned (move-only)
+	// Owned bytes are heap allocated, so views into them stay valid when the buffer moves.
+	class buffer {
+	private:
+		const char*			m_data{ nullptr };
+		std::size_t			m_size{ 0 };
+		bool				m_mapped{ false };
+		std::vector<char>	m_owned;
+
+		void unmap() noexcept
+		{
+			if (m_mapped && m_data) {
+#if defined(_WIN32)
+				UnmapViewOfFile(m_data);
+#else
+				munmap(const_cast<char*>(m_data), m_size);
+#endif
+			}
+			m_data = nullptr;
+			m_size = 0;
+			m_mapped = false;
+		}
+
+#if defined(_WIN32)
+		static std::system_error last_error(const std::string& what)
+		{
+			return std::system_error{ static_cast<int>(GetLastError()), std::system_category(), what };
+		}
+#else
+		static std::system_error last_error(const std::string& what)
+		{
+			return std::system_error{ errno, std::generic_category(), what };
+		}
+
+		// map the regular file open as fd, returns false if it is no regular file
+		bool map_fd(int fd, const std::string& what)
+		{
+			struct stat st{};
+			if (fstat(fd, &st) != 0) {
+				throw last_error(what);
+			}
+			if (!S_ISREG(st.st_mode)) {
+				return false;
+			}
+			m_mapped = true;
+			m_size = static_cast<std::size_t>(st.st_size);
+			if (m_size == 0) {
+				return true;	// mmap() refuses empty mappings
+			}
+			void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) {
+				m_size = 0;
+				throw last_error(what);
+			}
+			madvise(p, m_size, MADV_SEQUENTIAL);
+			m_data = static_cast<const char*>(p);
+			return true;
+		}
+#endif
+
+	public:
+		buffer() = default;
+		explicit buffer(std::vector<char> owned) noexcept
+			: m_data{ owned.data() }, m_size{ owned.size() }, m_owned{ std::move(owned) }
+		{}
+		buffer(buffer&& b) noexcept
+			: m_data{ std::exchange(b.m_data, nullptr) }, m_size{ std::exchange(b.m_size, 0) },
+			  m_mapped{ std::exchange(b.m_mapped, false) }, m_owned{ std::move(b.m_owned) }
+		{}
+		buffer& operator= (buffer&& b) noexcept
+		{
+			if (this != &b) {
+				unmap();
+				m_data = std::exchange(b.m_data, nullptr);
+				m_size = std::exchange(b.m_size, 0);
+				m_mapped = std::exchange(b.m_mapped, false);
+				m_owned = std::move(b.m_owned);
+			}
+			return *this;
+		}
+		buffer(const buffer&) = delete;
+		buffer& operator= (const buffer&) = delete;
+		~buffer()
+		{
+			unmap();
+		}
+
+		// map the file read-only
+		static buffer map(const std::string& path)
+		{
+			buffer buf;
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+									  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				throw last_error("cannot open " + path);
+			}
+			LARGE_INTEGER size{};
+			if (!GetFileSizeEx(file, &size)) {
+				std::system_error err = last_error("cannot stat " + path);
+				CloseHandle(file);
+				throw err;
+			}
+			buf.m_mapped = true;
+			if (size.QuadPart > 0) {
+				HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				const void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+				DWORD err = GetLastError();
+				if (mapping) {
+					CloseHandle(mapping);	// the view keeps the mapping alive
+				}
+				if (!p) {
+					CloseHandle(file);
+					throw std::system_error{ static_cast<int>(err), std::system_category(), "cannot map " + path };
+				}
+				buf.m_data = static_cast<const char*>(p);
+				buf.m_size = static_cast<std::size_t>(size.QuadPart);
+			}
+			CloseHandle(file);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw last_error("cannot open " + path);
+			}
+			try {
+				if (!buf.map_fd(fd, "cannot map " + path)) {
+					throw std::system_error{ std::make_error_code(std::errc::invalid_argument), path + " is no regular file" };
+				}
+			}
+			catch (...) {
+				close(fd);
+				throw;
+			}
+			close(fd);		// the mapping stays valid
+#endif
+			return buf;
+		}
+
+		// read strm up to its end into one owned buffer (doubling, so O(log n) allocations)
+		static buffer slurp(std::istream& strm)
+		{
+			std::vector<char> data;
+			std::size_t used = 0;
+			data.resize(std::size_t{ 1 } << 16);
+			while (strm.read(data.data() + used, static_cast<std::streamsize>(data.size() - used)) || strm.gcount() > 0) {
+				used += static_cast<std::size_t>(strm.gcount());
+				if (used == data.size()) {
+					data.resize(data.size() * 2);
+				}
+			}
+			data.resize(used);
+			return buffer{ std::move(data) };
+		}
+
+		// map stdin if it is redirected from a file, otherwise read std::cin up to its end
+		static buffer from_stdin()
+		{
+#if !defined(_WIN32)
+			buffer buf;
+			if (std::cin.rdbuf()->in_avail() <= 0 && buf.map_fd(STDIN_FILENO, "cannot map stdin")) {
+				return buf;
+			}
+#endif
+			return slurp(std::cin);
+		}
+
+		std::string_view view() const noexcept
+		{
+			return { m_data, m_size };
+		}
+		bool mapped() const noexcept
+		{
+			return m_mapped;
+		}
+	};
+
+	// split text into lines as std::getline() does (one allocation for the result)
+	inline std::vector<std::string_view> split(std::string_view text)
+	{
+		std::vector<std::string_view> res;
+		std::size_t num = static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+		res.reserve(num + 1);
+		const char* pos = text.data();
+		const char* end = pos + text.size();
+		while (pos != end) {
+			const char* nl = static_cast<const char*>(std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+			if (!nl) {
+				res.emplace_back(pos, static_cast<std::size_t>(end - pos));
+				break;
+			}
+			res.emplace_back(pos, static_cast<std::size_t>(nl - pos));
+			pos = nl + 1;
+		}
+		return res;
+	}
+
+	// cut text into at most num chunks of about equal size that end after a newline
+	// (or at the end of text), so every line lies in exactly one chunk
+	inline std::vector<std::string_view> chunks(std::string_view text, std::size_t num)
+	{
+		std::vector<std::string_view> res;
+		num = std::max<std::size_t>(num, 1);
+		res.reserve(num);
+		std::size_t pos = 0;
+		for (std::size_t i = 1; i <= num && pos < text.size(); ++i) {
+			std::size_t end = text.size();
+			if (i < num) {
+				std::size_t nl = text.find('\n', std::max(pos, text.size() / num * i));
+				end = nl == std::string_view::npos ? text.size() : nl + 1;
+			}
+			res.push_back(text.substr(pos, end - pos));
+			pos = end;
+		}
+		return res;
+	}
+
+	// Split text into owning lines with threads workers (0: one per hardware thread).
+	// Every worker builds its own vector from one chunk, then the vectors are concatenated
+	// by moving: the first one as a whole, the strings of the others one by one.
+	inline std::vector<std::string> split_parallel(std::string_view text, unsigned threads = 0)
+	{
+		constexpr std::size_t min_chunk = std::size_t{ 1 } << 16;	// not worth a thread below
+		if (threads == 0) {
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		std::vector<std::string_view> parts = chunks(text, std::min<std::size_t>(threads, text.size() / min_chunk + 1));
+
+		std::vector<std::vector<std::string>> rows(parts.size());
+		parallel::parallel_for(parts.size(), [&](std::size_t idx) {
+			std::vector<std::string_view> views = split(parts[idx]);
+			rows[idx].reserve(views.size());
+			for (std::string_view line : views) {
+				rows[idx].emplace_back(line);
+			}
+		});
+
+		if (rows.empty()) {
+			return {};
+		}
+		std::size_t total = 0;
+		for (const std::vector<std::string>& r : rows) {
+			total += r.size();
+		}
+		std::vector<std::string> res = std::move(rows[0]);
+		res.reserve(total);
+		for (std::size_t i = 1; i < rows.size(); ++i) {
+			std::move(rows[i].begin(), rows[i].end(), std::back_inserter(res));
+		}
+		return res;
+	}
+
+	// the lines of an input together with the bytes they view (move-only)
+	class lines {
+	private:
+		buffer							m_buf;
+		std::vector<std::string_view>	m_lines;
+	public:
+		explicit lines(buffer buf)
+			: m_buf{ std::move(buf) }, m_lines{ split(m_buf.view()) }
+		{}
+
+		static lines from_file(const std::string& path)
+		{
+			return lines{ buffer::map(path) };
+		}
+		static lines from_stream(std::istream& strm)
+		{
+			return lines{ buffer::slurp(strm) };
+		}
+		static lines from_stdin()
+		{
+			return lines{ buffer::from_stdin() };
+		}
+
+		using const_iterator = std::vector<std::string_view>::const_iterator;
+		const_iterator begin() const noexcept
+		{
+			return m_lines.begin();
+		}
+		const_iterator end() const noexcept
+		{
+			return m_lines.end();
+		}
+		std::size_t size() const noexcept
+		{
+			return m_lines.size();
+		}
+		bool empty() const noexcept
+		{
+			return m_lines.empty();
+		}
+		std::string_view operator[] (std::size_t idx) const noexcept
+		{
+			return m_lines[idx];
+		}
+		const buffer& data() const noexcept
+		{
+			return m_buf;
+		}
+
+		// owning copies of the lines (what the getline() loop produced)
+		std::vector<std::string> materialize() const
+		{
+			std::vector<std::string> res;
+			res.reserve(m_lines.size());
+			for (std::string_view line : m_lines) {
+				res.emplace_back(line);
+			}
+			return res;
+		}
+
+		// the same, splitting with threads workers (see split_parallel())
+		std::vector<std::string> materialize(unsigned threads) const
+		{
+			return split_parallel(m_buf.view(), threads);
+		}
+	};
+}
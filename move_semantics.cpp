@@ -22,250 +22,230 @@ using namespace std;
 #include "chapter_13.h"
 #include "chapter_14.h"
 #include "chapter_15.h"
+#include "sections.h"
+#include "benchmark.h"
+#include "alloccount.h"
+#include "smfcount.h"
 
-void chapter_1_run()
-{
-    chapter_1::sec_1_1_1::run();
-}
+// every section registers itself under its qualified name,
+// sections that are not registered cannot be run (see comments)
 
-void chapter_2_run()
-{
-    chapter_2::sec_2_1_1::run();
-    chapter_2::sec_2_1_2::run();
-    chapter_2::sec_2_2::run();
-    chapter_2::sec_2_3_1::run();
-    chapter_2::sec_2_3_2::run();
-    chapter_2::sec_2_3_3::run();
-    chapter_2::sec_2_4::run();
-    chapter_2::sec_2_5::run();
-}
+// chapter 1
+REGISTER_SECTION(chapter_1::sec_1_1_1::run);
 
-void chapter_3_run()
-{
-    chapter_3::sec_3_1::run();
-    chapter_3::sec_3_1::run_2();
-    chapter_3::sec_3_2::run();
-    chapter_3::sec_3_2::run_2();
-    chapter_3::sec_3_3_2::run();
-    chapter_3::sec_3_3_3::run();
-    chapter_3::sec_3_3_4::run();
-    chapter_3::sec_3_3_5::run();
-    chapter_3::sec_3_3_5b::run();
-    chapter_3::sec_3_3_6::run();
-    chapter_3::sec_3_3_7::run();
-}
+// chapter 2
+REGISTER_SECTION(chapter_2::sec_2_1_1::run);
+REGISTER_SECTION(chapter_2::sec_2_1_2::run);
+REGISTER_SECTION(chapter_2::sec_2_2::run);
+REGISTER_SECTION(chapter_2::sec_2_3_1::run);
+REGISTER_INTERACTIVE_SECTION(chapter_2::sec_2_3_2::run);
+REGISTER_INTERACTIVE_SECTION(chapter_2::sec_2_3_2::run2);
+REGISTER_SECTION(chapter_2::sec_2_3_2b::run);
+REGISTER_SECTION(chapter_2::sec_2_3_2c::run);
+REGISTER_SECTION(chapter_2::sec_2_3_3::run);
+REGISTER_SECTION(chapter_2::sec_2_4::run);
+REGISTER_SECTION(chapter_2::sec_2_5::run);
 
-void chapter_4_run()
-{
-    //chapter_4::sec_4_1::run();
-    //chapter_4::sec_4_1_1::run();
-    //chapter_4::sec_4_1_1::run2();
-    //chapter_4::sec_4_2::run();
-    //chapter_4::sec_4_3_1::run();
-    //chapter_4::sec_4_3_1b::run();
-    //chapter_4::sec_4_3_2::run();
-    //chapter_4::sec_4_3_3::run();
-    //chapter_4::sec_4_3_3::run_2();
-    //chapter_4::sec_4_3_3b::run();
-    //chapter_4::sec_4_3_3c::run();
-    chapter_4::sec_4_3_4::run();
-    chapter_4::sec_4_3_6::run();
-    chapter_4::sec_4_3_6::run2();
-    chapter_4::sec_4_3_6::run3();
+// chapter 3
+REGISTER_SECTION(chapter_3::sec_3_1::run);
+REGISTER_SECTION(chapter_3::sec_3_1::run_2);
+REGISTER_SECTION(chapter_3::sec_3_1b::run);
+REGISTER_SECTION(chapter_3::sec_3_1c::run);
+REGISTER_SECTION(chapter_3::sec_3_1d::run);
+REGISTER_SECTION(chapter_3::sec_3_1e::run);
+REGISTER_SECTION(chapter_3::sec_3_1f::run);
+REGISTER_SECTION(chapter_3::sec_3_1g::run);
+REGISTER_SECTION(chapter_3::sec_3_1h::run);
+REGISTER_SECTION(chapter_3::sec_3_2::run);
+REGISTER_SECTION(chapter_3::sec_3_2::run_2);
+REGISTER_SECTION(chapter_3::sec_3_2b::run);
+REGISTER_SECTION(chapter_3::sec_3_3_2::run);
+REGISTER_SECTION(chapter_3::sec_3_3_3::run);
+REGISTER_SECTION(chapter_3::sec_3_3_4::run);
+REGISTER_SECTION(chapter_3::sec_3_3_5::run);
+REGISTER_SECTION(chapter_3::sec_3_3_5b::run);
+REGISTER_SECTION(chapter_3::sec_3_3_6::run);
+REGISTER_SECTION(chapter_3::sec_3_3_7::run);
+REGISTER_SECTION(chapter_3::sec_3_3_7b::run);
 
-    chapter_4::sec_4_4::sec_4_4_1::slicing_problem::run();
-    chapter_4::sec_4_4::sec_4_4_1::solve_slicing_problem::run();
-    chapter_4::sec_4_4::sec_4_4_2a::run();
-    chapter_4::sec_4_4::sec_4_4_2b::run();
-}
+// chapter 4
+REGISTER_SECTION(chapter_4::sec_4_1::run);
+REGISTER_SECTION(chapter_4::sec_4_1_1::run);
+REGISTER_INTERACTIVE_SECTION(chapter_4::sec_4_1_1::run2);
+REGISTER_INTERACTIVE_SECTION(chapter_4::sec_4_1_1::run3);
+REGISTER_SECTION(chapter_4::sec_4_2::run);
+REGISTER_SECTION(chapter_4::sec_4_3_1::run);
+REGISTER_SECTION(chapter_4::sec_4_3_1b::run);
+REGISTER_SECTION(chapter_4::sec_4_3_2::run);
+REGISTER_SECTION(chapter_4::sec_4_3_3::run);
+REGISTER_SECTION(chapter_4::sec_4_3_3::run_2);
+REGISTER_SECTION(chapter_4::sec_4_3_3b::run);
+REGISTER_SECTION(chapter_4::sec_4_3_3c::run);
+REGISTER_SECTION(chapter_4::sec_4_3_4::run);
+REGISTER_SECTION(chapter_4::sec_4_3_4b::run);
+REGISTER_SECTION(chapter_4::sec_4_3_4c::run);
+REGISTER_SECTION(chapter_4::sec_4_3_5b::run);
+REGISTER_SECTION(chapter_4::sec_4_3_6::run);
+REGISTER_SECTION(chapter_4::sec_4_3_6::run2);
+REGISTER_SECTION(chapter_4::sec_4_3_6::run3);
+REGISTER_SECTION(chapter_4::sec_4_3_6b::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_1::slicing_problem::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_1::solve_slicing_problem::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_2a::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_2b::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_2c::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_2d::run);
+REGISTER_SECTION(chapter_4::sec_4_4::sec_4_4_2e::run);
 
-void chapter_5_run()
-{
-    //chapter_5::sec_5_1_1::run();
-    //chapter_5::sec_5_1_2::run();
-    chapter_5::sec_5_1_3::run();
-    chapter_5::sec_5_1_3::run2();
-    chapter_5::sec_5_1_3::run3();
-    chapter_5::sec_5_1_3::run4();
-    chapter_5::sec_5_1_3::run5();
-    chapter_5::sec_5_2::run();
-    chapter_5::sec_5_3::run();
-}
+// chapter 5
+REGISTER_SECTION(chapter_5::sec_5_1_1::run); // safe, only copies the names
+//REGISTER_SECTION(chapter_5::sec_5_1_2::run); // crash
+REGISTER_SECTION(chapter_5::sec_5_1_3::run);
+REGISTER_SECTION(chapter_5::sec_5_1_3::run2);
+REGISTER_SECTION(chapter_5::sec_5_1_3::run3);
+REGISTER_SECTION(chapter_5::sec_5_1_3::run4);
+REGISTER_SECTION(chapter_5::sec_5_1_3::run5);
+REGISTER_SECTION(chapter_5::sec_5_2::run);
+REGISTER_SECTION(chapter_5::sec_5_3::run);
 
-void chapter_6_run()
-{
-    //chapter_6::sec_6_2_1::run();
-    //chapter_6::sec_6_2_2::run();
-    //chapter_6::sec_6_2_2::run2();
-    //chapter_6::sec_6_3_2::run();
-    //chapter_6::sec_6_3_2::run();
-    //chapter_6::sec_6_3_3::run();
-    chapter_6::sec_6_3_3b::run();
-    std::cout << std::endl;
-}
+// chapter 6
+REGISTER_SECTION(chapter_6::sec_6_2_1::run); // prints a moved-from (valid but unspecified) customer
+REGISTER_SECTION(chapter_6::sec_6_2_2::run); // waits 2 s for its first thread in ~Tasks()
+//REGISTER_SECTION(chapter_6::sec_6_2_2::run2); // crash
+REGISTER_SECTION(chapter_6::sec_6_3_2::run); // dumps a moved-from (valid but unspecified) IntString
+//REGISTER_SECTION(chapter_6::sec_6_3_3::run); // crash
+REGISTER_SECTION(chapter_6::sec_6_3_3b::run);
 
-void chapter_7_run()
-{
-    chapter_7::sec_7_1_1::run();    
-    chapter_7::sec_7_1_2::run();
-    chapter_7::sec_7_1_2b::run();
-    chapter_7::sec_7_1_2c::run();
-    chapter_7::sec_7_1_3::run();
-    chapter_7::sec_7_2_2::run();
-    chapter_7::sec_7_2_2b::run();
-    chapter_7::sec_7_2_2c::run();
-    chapter_7::sec_7_2_2d::run();
-    chapter_7::sec_7_3a::run();
-    chapter_7::sec_7_3b::run();
-    std::cout << std::endl;
-}
+// chapter 7
+REGISTER_SECTION(chapter_7::sec_7_1_1::run);
+REGISTER_SECTION(chapter_7::sec_7_1_2::run);
+REGISTER_SECTION(chapter_7::sec_7_1_2b::run);
+REGISTER_SECTION(chapter_7::sec_7_1_2c::run);
+REGISTER_SECTION(chapter_7::sec_7_1_3::run);
+REGISTER_SECTION(chapter_7::sec_7_1_3b::run);
+REGISTER_SECTION(chapter_7::sec_7_2_2::run);
+REGISTER_SECTION(chapter_7::sec_7_2_2b::run);
+REGISTER_SECTION(chapter_7::sec_7_2_2c::run);
+REGISTER_SECTION(chapter_7::sec_7_2_2d::run);
+REGISTER_SECTION(chapter_7::sec_7_3a::run);
+REGISTER_SECTION(chapter_7::sec_7_3b::run);
 
-void chapter_8_run()
-{
-    chapter_8::sec_8_1_1::run();
-    chapter_8::sec_8_1_2::run();
-    chapter_8::sec_8_1_3::run();
-    chapter_8::sec_8_2_2::run();
-    chapter_8::sec_8_2_2b::run();
-    //chapter_8::sec_8_2_2c::run(); // crash
-    //chapter_8::sec_8_2_2d::run(); // crash
-    chapter_8::sec_8_3::run();
-    chapter_8::sec_8_3_1::run();
-    chapter_8::sec_8_4::run();
-    chapter_8::sec_8_5::run();
-    chapter_8::sec_8_6_1::run();
-    chapter_8::sec_8_6_2::run();
+// chapter 8
+REGISTER_SECTION(chapter_8::sec_8_1_1::run);
+REGISTER_SECTION(chapter_8::sec_8_1_2::run);
+REGISTER_SECTION(chapter_8::sec_8_1_3::run);
+REGISTER_SECTION(chapter_8::sec_8_2_2::run);
+REGISTER_SECTION(chapter_8::sec_8_2_2b::run);
+//REGISTER_SECTION(chapter_8::sec_8_2_2c::run); // crash
+//REGISTER_SECTION(chapter_8::sec_8_2_2d::run); // crash
+REGISTER_SECTION(chapter_8::sec_8_3::run);
+REGISTER_SECTION(chapter_8::sec_8_3_1::run);
+REGISTER_SECTION(chapter_8::sec_8_4::run);
+REGISTER_SECTION(chapter_8::sec_8_5::run);
+REGISTER_SECTION(chapter_8::sec_8_6_1::run);
+REGISTER_SECTION(chapter_8::sec_8_6_2::run);
 
-    std::cout << std::endl;
-}
+// chapter 9
+REGISTER_SECTION(chapter_9::sec_9_1_1a::run);
+REGISTER_SECTION(chapter_9::sec_9_1_1b::run);
+REGISTER_SECTION(chapter_9::sec_9_1_1c::run);
+REGISTER_SECTION(chapter_9::sec_9_2a::run);
+REGISTER_SECTION(chapter_9::sec_9_2b::run);
+REGISTER_SECTION(chapter_9::sec_9_2c::run);
+REGISTER_SECTION(chapter_9::sec_9_2_1a::run);
+//REGISTER_SECTION(chapter_9::sec_9_2_1b::run); // const version
+//REGISTER_SECTION(chapter_9::sec_9_2_1c::run); // volatile version
+REGISTER_SECTION(chapter_9::sec_9_2_2::run);
+REGISTER_SECTION(chapter_9::sec_9_2_3::run);
+REGISTER_SECTION(chapter_9::sec_9_3_1::run);
+//REGISTER_SECTION(chapter_9::sec_9_3_2::run);
+REGISTER_SECTION(chapter_9::sec_9_4_1::run);
+REGISTER_SECTION(chapter_9::sec_9_4_1a::run);
+REGISTER_SECTION(chapter_9::sec_9_4_1b::run);
+REGISTER_SECTION(chapter_9::sec_9_5::run);
+REGISTER_SECTION(chapter_9::sec_9_5::run2);
 
-void chapter_9_run()
-{
-    chapter_9::sec_9_1_1a::run();
-    chapter_9::sec_9_1_1b::run();
-    chapter_9::sec_9_1_1c::run();
-    chapter_9::sec_9_2a::run();
-    chapter_9::sec_9_2b::run();
-    chapter_9::sec_9_2c::run();
-    chapter_9::sec_9_2_1a::run();
-    //chapter_9::sec_9_2_1b::run();   // const version
-    //chapter_9::sec_9_2_1c::run();   // volatile version
-    chapter_9::sec_9_2_2::run();
-    chapter_9::sec_9_2_3::run();
-    chapter_9::sec_9_3_1::run();
-    //chapter_9::sec_9_3_2::run();
-    chapter_9::sec_9_4_1::run();
-    chapter_9::sec_9_4_1a::run();
-    chapter_9::sec_9_4_1b::run();
-    
-    chapter_9::sec_9_5::run();
-    chapter_9::sec_9_5::run2();
+// chapter 10
+REGISTER_SECTION(chapter_10::sec_10_1_1::run);
+REGISTER_SECTION(chapter_10::sec_10_1_2::run);
+REGISTER_SECTION(chapter_10::sec_10_1_3a::run);
+REGISTER_SECTION(chapter_10::sec_10_1_3b::run);
+REGISTER_SECTION(chapter_10::sec_10_1_3c::run);
+REGISTER_SECTION(chapter_10::sec_10_1_3d::run);
+REGISTER_SECTION(chapter_10::sec_10_1_3e::run);
+REGISTER_SECTION(chapter_10::sec_10_2_2::run);
+REGISTER_SECTION(chapter_10::sec_10_3::run);
+REGISTER_SECTION(chapter_10::sec_10_3_1a::run);
+REGISTER_SECTION(chapter_10::sec_10_3_1b::run);
+//REGISTER_SECTION(chapter_10::sec_10_3_2a::run); // compiler ERROR
+REGISTER_SECTION(chapter_10::sec_10_3_2b::run);
+REGISTER_SECTION(chapter_10::sec_10_3_2c::run);
+REGISTER_SECTION(chapter_10::sec_10_3_2d::run);
+REGISTER_SECTION(chapter_10::sec_10_3_3a::run);
+REGISTER_SECTION(chapter_10::sec_10_3_3b::run);
 
-    std::cout << std::endl;
-}
+// chapter 11
+REGISTER_SECTION(chapter_11::sec_11_1_1::run);
+REGISTER_SECTION(chapter_11::sec_11_2::run);
+REGISTER_SECTION(chapter_11::sec_11_2_1::run);
+REGISTER_SECTION(chapter_11::sec_11_2_2::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1a::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1b::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1c::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1d::run);
+// !!!! BUG REGISTER_SECTION(chapter_11::sec_11_3_1e::run); // !!!! BUG
+//REGISTER_SECTION(chapter_11::sec_11_3_1f::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1g::run);
+//REGISTER_SECTION(chapter_11::sec_11_3_1h::run);
+REGISTER_SECTION(chapter_11::sec_11_3_1i::run);
+REGISTER_SECTION(chapter_11::sec_11_4a::run);
+REGISTER_SECTION(chapter_11::sec_11_4b::run);
+REGISTER_SECTION(chapter_11::sec_11_4c::run);
+REGISTER_SECTION(chapter_11::sec_11_5a::run);
+REGISTER_SECTION(chapter_11::sec_11_5b::run);
 
-void chapter_10_run()
-{
-    chapter_10::sec_10_1_1::run();
-    chapter_10::sec_10_1_2::run();
-    chapter_10::sec_10_1_3a::run();
-    chapter_10::sec_10_1_3b::run();
-    chapter_10::sec_10_1_3c::run();
-    chapter_10::sec_10_1_3d::run();
-    chapter_10::sec_10_1_3e::run();
-    chapter_10::sec_10_2_2::run();
-    chapter_10::sec_10_3::run();
-    chapter_10::sec_10_3_1a::run(); 
-    chapter_10::sec_10_3_1b::run();
-    //chapter_10::sec_10_3_2a::run(); // compiler ERROR
-    chapter_10::sec_10_3_2b::run();
-    chapter_10::sec_10_3_2c::run();
-    chapter_10::sec_10_3_2d::run();
-    chapter_10::sec_10_3_3a::run();
-    chapter_10::sec_10_3_3b::run();
+// chapter 12
+REGISTER_SECTION(chapter_12::sec_12_1::run);
+REGISTER_SECTION(chapter_12::sec_12_2a::run);
+REGISTER_SECTION(chapter_12::sec_12_2b::run);
+REGISTER_SECTION(chapter_12::sec_12_2c::run);
+REGISTER_SECTION(chapter_12::sec_12_2d::run);
+REGISTER_SECTION(chapter_12::sec_12_2e::run);
+REGISTER_SECTION(chapter_12::sec_12_2_1::run);
 
-    std::cout << std::endl;
-}
+// chapter 13
+REGISTER_SECTION(chapter_13::sec_13_1_1::run);
+REGISTER_SECTION(chapter_13::sec_13_1_2::run);
+REGISTER_SECTION(chapter_13::sec_13_1_2b::run);
+REGISTER_SECTION(chapter_13::sec_13_1_2c::run);
+REGISTER_SECTION(chapter_13::sec_13_1_3a::run);
+REGISTER_SECTION(chapter_13::sec_13_1_3b::run);
+REGISTER_SECTION(chapter_13::sec_13_1_3c::run);
+REGISTER_SECTION(chapter_13::sec_13_1_4::run);
 
-void chapter_11_run()
-{
-    chapter_11::sec_11_1_1::run();
-    chapter_11::sec_11_2::run();
-    chapter_11::sec_11_2_1::run();
-    chapter_11::sec_11_2_2::run();
-    chapter_11::sec_11_3_1a::run();
-    chapter_11::sec_11_3_1b::run();
-    chapter_11::sec_11_3_1c::run();
-    chapter_11::sec_11_3_1d::run();
-    // !!!! BUG chapter_11::sec_11_3_1e::run(); // !!!! BUG
-    //chapter_11::sec_11_3_1f::run();
-    chapter_11::sec_11_3_1g::run();
-    //chapter_11::sec_11_3_1h::run();
-    chapter_11::sec_11_3_1i::run();
-    chapter_11::sec_11_4a::run();
-    chapter_11::sec_11_4b::run();
-    chapter_11::sec_11_4c::run();
-    chapter_11::sec_11_5a::run();
-    chapter_11::sec_11_5b::run();
+// chapter 14
+REGISTER_SECTION(chapter_14::sec_14_1::run);
+REGISTER_SECTION(chapter_14::sec_14_2::run);
+REGISTER_SECTION(chapter_14::sec_14_3_1::run);
+REGISTER_SECTION(chapter_14::sec_14_3_2::run);
 
-    std::cout << std::endl;
-}
+// chapter 15
+REGISTER_SECTION(chapter_15::sec_15_1::run);
 
-void chapter_12_run()
+int main(int argc, char* argv[])
 {
-    chapter_12::sec_12_1::run();
-    chapter_12::sec_12_2a::run();
-    chapter_12::sec_12_2b::run();
-    chapter_12::sec_12_2c::run();
-    chapter_12::sec_12_2d::run();
-    chapter_12::sec_12_2e::run();
-    chapter_12::sec_12_2_1::run();
-}
-
-void chapter_13_run()
-{
-    chapter_13::sec_13_1_1::run();
-    chapter_13::sec_13_1_2::run();
-    chapter_13::sec_13_1_2b::run();
-    chapter_13::sec_13_1_2c::run();
-    chapter_13::sec_13_1_3a::run();
-    chapter_13::sec_13_1_3b::run();
-    chapter_13::sec_13_1_3c::run();
-    chapter_13::sec_13_1_4::run();
-}
-
-void chapter_14_run()
-{
-    chapter_14::sec_14_1::run();
-    chapter_14::sec_14_2::run();
-    chapter_14::sec_14_3_1::run();
-    chapter_14::sec_14_3_2::run();
-}
-
-void chapter_15_run()
-{
-    chapter_15::sec_15_1::run();
-}
-
-int main()
-{
-    //chapter_1_run();
-    //chapter_2_run();
-    //chapter_3_run();
-    //chapter_4_run();
-    //chapter_5_run();
-    //chapter_6_run();
-    //chapter_7_run();
-    //chapter_8_run();
-    //chapter_9_run();
-    //chapter_10_run();
-    //chapter_11_run();
-    //chapter_12_run();
-    //chapter_13_run();
-    //chapter_14_run();
-    chapter_15_run();
-
-    cin.get();
+    // e.g. move_semantics --quiet --warmup 1 --reps 5 'chapter_7::sec_7_1_3::*'
+    sections::options opts;
+    if (!sections::parse_args(argc, argv, opts)) {
+        return 2;
+    }
+    smfcount::tracing() = opts.trace;
+    benchmark::settings().json = opts.json;
+    benchmark::settings().perf = opts.perf;
+    if (opts.samples > 0) {
+        benchmark::settings().samples = opts.samples;
+    }
+    return sections::run(opts);
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
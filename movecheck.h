@@ -0,0 +1,207 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+// Compile-time check for moves that degrade to copies
+// A class with a member that cannot be moved (e.g. chapter_3::sec_3_3_7::Customer, which
+// deletes its move operations, or a type with a user-declared copy constructor and no move
+// constructor) still "moves": the generated move operations copy that member, and nothing
+// warns about it. Listing the members inside the class
+//
+//		class Invoice {
+//			std::string	m_id;
+//			Customer	m_cust;
+//		public:
+//			MOVECHECK_MEMBERS(m_id, m_cust)
+//		};
+//
+// lets the trait walk them:
+//
+//		static_assert(movecheck::is_cheaply_movable_v<Invoice>);	// fails: m_cust is copied
+//		movecheck::report<Invoice>(std::cout);						// one line per member
+//
+// A member is fine if moving it (construction and assignment) really moves and is noexcept.
+// Types without a member list are checked as a whole.
+// "Really moves" is detected with a probe convertible to both T&& and const T&: if T has a
+// move operation (even a deleted one), both candidates are viable and the call is ambiguous;
+// only a type that has nothing but the copy operation can be initialized from it.
+// (Types with a constructor template that accepts anything defeat the probe; for them only
+// noexcept is checked.)
+namespace movecheck
+{
+	enum class verdict {
+		moves,				// moves and is noexcept
+		moves_may_throw,	// moves, but not noexcept (vectors copy on reallocation)
+		copies,				// no move operation, moving calls the copy operation
+		move_deleted,		// move operation deleted, moving the enclosing class copies
+		immovable			// neither movable nor copyable
+	};
+
+	constexpr const char* describe(verdict v) noexcept
+	{
+		switch (v) {
+		case verdict::moves:
+			return "moves";
+		case verdict::moves_may_throw:
+			return "moves, but not noexcept";
+		case verdict::copies:
+			return "COPIES (no move operation)";
+		case verdict::move_deleted:
+			return "COPIES (move operation deleted)";
+		case verdict::immovable:
+			return "NOT MOVABLE";
+		}
+		return "?";
+	}
+
+	namespace detail
+	{
+		template <typename T>
+		struct probe {
+			operator T&& () const;
+			operator const T& () const;
+		};
+
+		// converts to nothing: if T accepts it (a constructor template taking anything),
+		// the probe proves nothing
+		template <typename T>
+		struct unrelated {
+		};
+
+		template <typename T>
+		constexpr verdict construct_verdict() noexcept
+		{
+			if constexpr (std::is_constructible_v<T, probe<T>> && !std::is_constructible_v<T, unrelated<T>>) {
+				return verdict::copies;
+			}
+			else if constexpr (!std::is_move_constructible_v<T>) {
+				return std::is_copy_constructible_v<T> ? verdict::move_deleted : verdict::immovable;
+			}
+			else if constexpr (!std::is_nothrow_move_constructible_v<T>) {
+				return verdict::moves_may_throw;
+			}
+			else {
+				return verdict::moves;
+			}
+		}
+
+		template <typename T>
+		constexpr verdict assign_verdict() noexcept
+		{
+			if constexpr (std::is_assignable_v<T&, probe<T>> && !std::is_assignable_v<T&, unrelated<T>>) {
+				return verdict::copies;
+			}
+			else if constexpr (!std::is_move_assignable_v<T>) {
+				return std::is_copy_assignable_v<T> ? verdict::move_deleted : verdict::immovable;
+			}
+			else if constexpr (!std::is_nothrow_move_assignable_v<T>) {
+				return verdict::moves_may_throw;
+			}
+			else {
+				return verdict::moves;
+			}
+		}
+	}
+
+	// how moving a T by construction and by assignment behaves
+	// (const members and references can't be assigned at all, so only their construction counts)
+	template <typename T>
+	struct move_traits {
+		static constexpr verdict construct = std::is_reference_v<T> ? verdict::moves : detail::construct_verdict<T>();
+		static constexpr verdict assign = std::is_const_v<T> || std::is_reference_v<T>
+			? verdict::moves : detail::assign_verdict<std::remove_cv_t<T>>();
+		static constexpr bool ok = construct == verdict::moves && assign == verdict::moves;
+	};
+
+	// the member types of a class and their names as written in MOVECHECK_MEMBERS()
+	template <typename... Members>
+	struct member_list {
+		std::string_view names;
+		static constexpr std::size_t size = sizeof...(Members);
+		static constexpr std::array<verdict, size> construct{ move_traits<Members>::construct... };
+		static constexpr std::array<verdict, size> assign{ move_traits<Members>::assign... };
+		static constexpr bool ok = (move_traits<Members>::ok && ...);
+	};
+
+	template <typename T>
+	concept has_member_list = requires {
+		T::movecheck_members();
+	};
+
+	// T and all its listed members move cheaply (really move, noexcept)
+	template <typename T>
+	constexpr bool is_cheaply_movable() noexcept
+	{
+		if constexpr (has_member_list<T>) {
+			return decltype(T::movecheck_members())::ok && move_traits<T>::ok;
+		}
+		else {
+			return move_traits<T>::ok;
+		}
+	}
+	template <typename T>
+	inline constexpr bool is_cheaply_movable_v = is_cheaply_movable<T>();
+
+	// print one line per member (or for T as a whole if it has no member list)
+	template <typename T>
+	void report(std::ostream& strm, std::string_view type_name = "type")
+	{
+		auto line = [&](std::string_view what, verdict construct, verdict assign) {
+			strm << "  " << what << ": move construct " << describe(construct)
+				 << ", move assign " << describe(assign) << '\n';
+		};
+		strm << type_name << (is_cheaply_movable_v<T> ? " moves cheaply\n" : " does NOT move cheaply\n");
+		line("as a whole", move_traits<T>::construct, move_traits<T>::assign);
+		if constexpr (has_member_list<T>) {
+			auto members = T::movecheck_members();
+			std::string_view names = members.names;
+			for (std::size_t i = 0; i < members.size; ++i) {
+				std::size_t comma = names.find(',');
+				std::string_view name = names.substr(0, comma);
+				names = comma == std::string_view::npos ? std::string_view{} : names.substr(comma + 1);
+				while (!name.empty() && name.front() == ' ') {
+					name.remove_prefix(1);
+				}
+				line(name, members.construct[i], members.assign[i]);
+			}
+		}
+	}
+}
+
+// decltype() of every argument (up to 16 members)
+// (MOVECHECK_EXPAND() makes the traditional MSVC preprocessor split __VA_ARGS__)
+#define MOVECHECK_EXPAND(x) x
+#define MOVECHECK_DECLTYPE_1(m) decltype(m)
+#define MOVECHECK_DECLTYPE_2(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_1(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_3(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_2(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_4(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_3(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_5(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_4(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_6(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_5(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_7(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_6(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_8(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_7(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_9(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_8(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_10(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_9(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_11(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_10(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_12(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_11(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_13(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_12(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_14(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_13(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_15(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_14(__VA_ARGS__))
+#define MOVECHECK_DECLTYPE_16(m, ...) decltype(m), MOVECHECK_EXPAND(MOVECHECK_DECLTYPE_15(__VA_ARGS__))
+#define MOVECHECK_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, name, ...) name
+#define MOVECHECK_DECLTYPES(...) \
+	MOVECHECK_EXPAND(MOVECHECK_SELECT(__VA_ARGS__, MOVECHECK_DECLTYPE_16, MOVECHECK_DECLTYPE_15, MOVECHECK_DECLTYPE_14, \
+		MOVECHECK_DECLTYPE_13, MOVECHECK_DECLTYPE_12, MOVECHECK_DECLTYPE_11, MOVECHECK_DECLTYPE_10, \
+		MOVECHECK_DECLTYPE_9, MOVECHECK_DECLTYPE_8, MOVECHECK_DECLTYPE_7, MOVECHECK_DECLTYPE_6, \
+		MOVECHECK_DECLTYPE_5, MOVECHECK_DECLTYPE_4, MOVECHECK_DECLTYPE_3, MOVECHECK_DECLTYPE_2, \
+		MOVECHECK_DECLTYPE_1)(__VA_ARGS__))
+
+// list the data members of the enclosing class (inside the class, any access)
+#define MOVECHECK_MEMBERS(...) \
+	static constexpr auto movecheck_members() \
+	{ \
+		return movecheck::member_list<MOVECHECK_DECLTYPES(__VA_ARGS__)>{ #__VA_ARGS__ }; \
+	}
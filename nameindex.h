@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Name index over customers
+// Finding a customer by name in a std::vector<Customer> is a linear scan that copies every
+// name (get_name() returns by value). NameIndex owns the customers (moved in) and a hash
+// index from name to position, which supports lookups by std::string_view, so probing
+// never creates a temporary string:
+//
+//		nameindex::NameIndex<Customer> idx{ std::move(coll) };
+//		if (const Customer* cust = idx.find("Wolfgang Amadeus Mozart")) { ... }
+//
+// The index stores positions, not pointers, so growing the container (which moves the
+// customers) keeps it valid. erase() moves the last customer into the gap and updates its
+// position through its map entry (no name copy); reorder() lets callers move the customers
+// around (e.g. sort) and rebuilds the index afterwards. Names are unique.
+namespace nameindex
+{
+	// hash that accepts everything convertible to std::string_view (heterogeneous lookup)
+	struct name_hash {
+		using is_transparent = void;
+		std::size_t operator() (std::string_view name) const noexcept
+		{
+			return std::hash<std::string_view>{}(name);
+		}
+	};
+
+	template <typename C>
+	class NameIndex {
+	private:
+		using index_type = std::unordered_map<std::string, std::size_t, name_hash, std::equal_to<>>;
+
+		std::vector<C> m_customers;
+		index_type m_index;
+		std::vector<typename index_type::value_type*> m_entries;	// map entry of each customer (stable on rehash)
+
+		// index coll (the customers or the ones about to be taken over)
+		void build(const std::vector<C>& coll)
+		{
+			m_index.clear();
+			m_entries.clear();
+			m_index.reserve(coll.size());
+			m_entries.reserve(coll.size());
+			for (std::size_t i = 0; i < coll.size(); ++i) {
+				auto [pos, inserted] = m_index.try_emplace(coll[i].get_name(), i);
+				if (!inserted) {
+					throw std::invalid_argument{ "duplicate customer name: " + pos->first };
+				}
+				m_entries.push_back(&*pos);
+			}
+		}
+
+	public:
+		NameIndex() = default;
+
+		// take over all customers (names must be unique, coll is left untouched if they are not)
+		explicit NameIndex(std::vector<C>&& coll)
+		{
+			build(coll);
+			m_customers = std::move(coll);
+		}
+
+		C* find(std::string_view name)
+		{
+			auto pos = m_index.find(name);
+			return pos != m_index.end() ? &m_customers[pos->second] : nullptr;
+		}
+		const C* find(std::string_view name) const
+		{
+			auto pos = m_index.find(name);
+			return pos != m_index.end() ? &m_customers[pos->second] : nullptr;
+		}
+		bool contains(std::string_view name) const
+		{
+			return m_index.find(name) != m_index.end();
+		}
+
+		// insert cust unless its name exists already, returns the customer with the name and
+		// whether cust was inserted
+		std::pair<C*, bool> insert(C cust)
+		{
+			auto [pos, inserted] = m_index.try_emplace(cust.get_name(), m_customers.size());
+			if (!inserted) {
+				return { &m_customers[pos->second], false };
+			}
+			try {
+				m_entries.push_back(&*pos);
+				m_customers.push_back(std::move(cust));
+			}
+			catch (...) {
+				if (m_entries.size() > m_customers.size()) {
+					m_entries.pop_back();
+				}
+				m_index.erase(pos);
+				throw;
+			}
+			return { &m_customers.back(), true };
+		}
+
+		// erase the customer with name (moves the last customer into its place)
+		bool erase(std::string_view name)
+		{
+			auto pos = m_index.find(name);
+			if (pos == m_index.end()) {
+				return false;
+			}
+			std::size_t idx = pos->second;
+			m_index.erase(pos);
+			if (idx + 1 != m_customers.size()) {
+				m_customers[idx] = std::move(m_customers.back());
+				m_entries[idx] = m_entries.back();
+				m_entries[idx]->second = idx;
+			}
+			m_customers.pop_back();
+			m_entries.pop_back();
+			return true;
+		}
+
+		// let func(std::vector<C>&) move the customers around (or change names), then rebuild the index
+		template <typename Func>
+		void reorder(Func&& func)
+		{
+			func(m_customers);
+			build(m_customers);
+		}
+
+		// hand the customers back (the index is empty afterwards)
+		std::vector<C> release()
+		{
+			m_index.clear();
+			m_entries.clear();
+			return std::move(m_customers);
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_customers.size();
+		}
+		bool empty() const noexcept
+		{
+			return m_customers.empty();
+		}
+		const std::vector<C>& customers() const noexcept
+		{
+			return m_customers;
+		}
+	};
+}
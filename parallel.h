@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Fan-out over threads
+// Runs func(0) .. func(num - 1) on num threads, the calling thread takes func(0); waits
+// for all of them and rethrows the first exception (by index) any of them threw. If a
+// thread cannot be started, the ones already running are joined and the error is rethrown:
+//
+//		std::vector<result> partial(parts);
+//		parallel::parallel_for(parts, [&](std::size_t part) {
+//			partial[part] = work(num * part / parts, num * (part + 1) / parts);
+//		});
+namespace parallel
+{
+	template <typename Func>
+	void parallel_for(std::size_t num, Func&& func)
+	{
+		std::vector<std::exception_ptr> errors(num);
+		auto work = [&](std::size_t i) {
+			try {
+				func(i);
+			}
+			catch (...) {
+				errors[i] = std::current_exception();
+			}
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(num);
+		try {
+			for (std::size_t i = 1; i < num; ++i) {
+				workers.emplace_back(work, i);
+			}
+		}
+		catch (...) {
+			for (std::thread& t : workers) {	// joinable threads would terminate on destruction
+				t.join();
+			}
+			throw;
+		}
+		if (num > 0) {
+			work(0);
+		}
+		for (std::thread& t : workers) {
+			t.join();
+		}
+		for (const std::exception_ptr& err : errors) {
+			if (err) {
+				std::rethrow_exception(err);
+			}
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters (Linux perf_event_open)
+// Counts cycles, instructions, L1 data cache misses, last level cache misses and branch
+// misses of the calling thread in user space between start() and stop().
+// The counters form one group led by cycles, so the kernel schedules them together and
+// one read returns all of them; if it has to multiplex, the counts are scaled by the
+// enabled and running times of the interval (both are deltas, a reset would not clear them).
+// Counters the kernel refuses (other platforms, perf_event_paranoid, no PMU in a VM)
+// are simply not valid, available() tells whether any counter could be opened.
+namespace perfcount
+{
+	enum counter : std::size_t {
+		cycles, instructions, l1d_misses, llc_misses, branch_misses, num_counters
+	};
+
+	inline constexpr const char* counter_names[num_counters]{
+		"cycles", "instructions", "L1d misses", "LLC misses", "branch misses"
+	};
+
+	struct sample {
+		std::array<double, num_counters>	values{};	// scaled if the kernel had to multiplex
+		std::array<bool, num_counters>		valid{};
+
+		double ipc() const
+		{
+			return valid[cycles] && valid[instructions] && values[cycles] > 0
+				? values[instructions] / values[cycles] : 0.0;
+		}
+
+		sample& operator+= (const sample& s)
+		{
+			for (std::size_t i = 0; i < num_counters; ++i) {
+				values[i] += s.values[i];
+				valid[i] = valid[i] || s.valid[i];
+			}
+			return *this;
+		}
+	};
+
+	class counters {
+	private:
+		std::array<int, num_counters> m_fd;
+		int m_leader{ -1 };							// the first counter opened (cycles if available)
+		std::array<counter, num_counters> m_slot{};	// counter of each value of a group read
+		std::size_t m_num{ 0 };						// counters in the group
+
+		// layout of a read with PERF_FORMAT_GROUP and both times
+		struct group_read {
+			std::uint64_t nr{ 0 };
+			std::uint64_t time_enabled{ 0 };
+			std::uint64_t time_running{ 0 };
+			std::uint64_t values[num_counters]{};
+		};
+		group_read m_start;
+
+#if defined(__linux__)
+		static int open(std::uint32_t type, std::uint64_t config, int group_fd)
+		{
+			perf_event_attr attr{};
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = group_fd < 0 ? 1 : 0;		// members count whenever the leader does
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+		}
+
+		void add(counter cnt, std::uint32_t type, std::uint64_t config)
+		{
+			int fd = open(type, config, m_leader);
+			if (fd < 0) {
+				return;
+			}
+			if (m_leader < 0) {
+				m_leader = fd;
+			}
+			m_fd[cnt] = fd;
+			m_slot[m_num++] = cnt;		// group reads return the values in the order of joining
+		}
+
+		bool read_group(group_read& buf) const
+		{
+			ssize_t len = read(m_leader, &buf, sizeof(buf));
+			return len >= static_cast<ssize_t>(3 * sizeof(std::uint64_t)) && buf.nr == m_num;
+		}
+#endif
+
+	public:
+		counters()
+		{
+			m_fd.fill(-1);
+#if defined(__linux__)
+			add(cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			add(instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			add(l1d_misses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+												| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+												| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+			add(llc_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+			add(branch_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+		}
+		~counters()
+		{
+#if defined(__linux__)
+			for (int fd : m_fd) {
+				if (fd >= 0 && fd != m_leader) {
+					close(fd);
+				}
+			}
+			if (m_leader >= 0) {
+				close(m_leader);
+			}
+#endif
+		}
+		counters(const counters&) = delete;
+		counters& operator= (const counters&) = delete;
+
+		bool available() const
+		{
+			return m_leader >= 0;
+		}
+
+		void start()
+		{
+#if defined(__linux__)
+			if (m_leader < 0) {
+				return;
+			}
+			if (!read_group(m_start)) {		// the times keep counting across runs, so remember them
+				m_start.nr = 0;
+			}
+			ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+		}
+
+		sample stop()
+		{
+			sample res;
+#if defined(__linux__)
+			if (m_leader < 0) {
+				return res;
+			}
+			ioctl(m_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+			group_read end;
+			if (m_start.nr != m_num || !read_group(end)) {
+				return res;
+			}
+			std::uint64_t enabled = end.time_enabled - m_start.time_enabled;
+			std::uint64_t running = end.time_running - m_start.time_running;
+			if (running == 0) {
+				return res;		// the group never got onto the PMU
+			}
+			double scale = static_cast<double>(enabled) / static_cast<double>(running);
+			for (std::size_t i = 0; i < m_num; ++i) {
+				res.values[m_slot[i]] = static_cast<double>(end.values[i] - m_start.values[i]) * scale;
+				res.valid[m_slot[i]] = true;
+			}
+#endif
+			return res;
+		}
+	};
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Relocation-aware swap, reverse and rotate
+// Swapping through a temporary (as chapter_2::sec_2_3_2::swap does) costs three moves,
+// and every move of e.g. a std::vector reads and writes all pointers and nulls the source.
+// For types whose objects can be moved to another address by copying their bytes
+// (no pointers into themselves, no registration by address) relocation is a plain memcpy:
+//
+//		class Customer {
+//			std::string			m_name;
+//			std::vector<int>	m_values;
+//		public:
+//			using trivially_relocatable = relocate::all_trivially_relocatable<std::string, std::vector<int>>;
+//			...
+//		};
+//
+// Types have to opt in, by such a member or by specializing is_trivially_relocatable
+// (trivially copyable types are in by default). Everything else falls back to its own
+// swap or the three moves of std::swap, so using relocate::swap() is always correct.
+namespace relocate
+{
+	template <typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+	// opt in by member
+	template <typename T>
+		requires requires { typename T::trivially_relocatable; }
+	struct is_trivially_relocatable<T>
+		: std::bool_constant<std::is_trivially_copyable_v<T> || T::trivially_relocatable::value> {};
+
+	template <typename T>
+	inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
+
+	// a class is trivially relocatable if all its members (and bases) are
+	// (and it has no user provided special member functions that depend on its address)
+	template <typename... Ts>
+	struct all_trivially_relocatable : std::bool_constant<(is_trivially_relocatable_v<Ts> && ...)> {};
+
+	// std::vector with the standard allocator is three pointers in libstdc++, libc++ and
+	// the MSVC STL, but iterator debugging registers containers by address
+#if !defined(_GLIBCXX_DEBUG) && !(defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL > 0)
+	template <typename T>
+	struct is_trivially_relocatable<std::vector<T>> : std::true_type {};
+#endif
+
+	// std::unique_ptr with the default deleter is a single pointer
+	template <typename T>
+	struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+	// std::string of libc++ and of the MSVC STL (without iterator debugging) holds no pointer
+	// to itself, the one of libstdc++ points to its SSO buffer if the value is short
+#if defined(_LIBCPP_VERSION) || (defined(_MSVC_STL_VERSION) && !(defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL > 0))
+	template <>
+	struct is_trivially_relocatable<std::string> : std::true_type {};
+#endif
+
+	// swap a and b with three moves
+	template <typename T>
+	void move_swap(T& a, T& b)
+	{
+		T tmp{ std::move(a) };
+		a = std::move(b);
+		b = std::move(tmp);
+	}
+
+	namespace detail
+	{
+		// the swap of T if it has one, otherwise std::swap (three moves)
+		template <typename T>
+		void adl_swap(T& a, T& b) noexcept(std::is_nothrow_swappable_v<T>)
+		{
+			using std::swap;
+			swap(a, b);
+		}
+	}
+
+	// swap a and b by relocating their bytes (if T is trivially relocatable)
+	template <typename T>
+	void swap(T& a, T& b) noexcept(is_trivially_relocatable_v<T> || std::is_nothrow_swappable_v<T>)
+	{
+		if constexpr (is_trivially_relocatable_v<T>) {
+			if (std::addressof(a) == std::addressof(b)) {
+				return;		// memcpy() must not overlap
+			}
+			alignas(T) unsigned char tmp[sizeof(T)];
+			std::memcpy(tmp, static_cast<void*>(std::addressof(a)), sizeof(T));
+			std::memcpy(static_cast<void*>(std::addressof(a)), static_cast<const void*>(std::addressof(b)), sizeof(T));
+			std::memcpy(static_cast<void*>(std::addressof(b)), tmp, sizeof(T));
+		}
+		else {
+			detail::adl_swap(a, b);
+		}
+	}
+
+	template <std::bidirectional_iterator It>
+	void reverse(It first, It last)
+	{
+		while (first != last && first != --last) {
+			relocate::swap(*first, *last);
+			++first;
+		}
+	}
+
+	namespace detail
+	{
+		// bytes up to which rotate() relocates the smaller part through a buffer on the stack
+		constexpr std::size_t rotate_buffer = 1024;
+	}
+
+	// rotate [first, last) so that middle becomes the first element, returns the new position of first
+	// Relocatable elements in contiguous memory move by memmove() if the smaller part fits
+	// into a small buffer, otherwise (and for all other types) three reversals are used.
+	template <std::bidirectional_iterator It>
+	It rotate(It first, It middle, It last)
+	{
+		if (first == middle) {
+			return last;
+		}
+		if (middle == last) {
+			return first;
+		}
+		using T = std::iter_value_t<It>;
+		if constexpr (std::contiguous_iterator<It> && is_trivially_relocatable_v<T>) {
+			std::size_t left = static_cast<std::size_t>(middle - first);
+			std::size_t right = static_cast<std::size_t>(last - middle);
+			if (std::min(left, right) * sizeof(T) <= detail::rotate_buffer) {
+				alignas(T) unsigned char buf[detail::rotate_buffer];
+				unsigned char* base = reinterpret_cast<unsigned char*>(std::to_address(first));
+				if (left <= right) {
+					std::memcpy(buf, base, left * sizeof(T));
+					std::memmove(base, base + left * sizeof(T), right * sizeof(T));
+					std::memcpy(base + right * sizeof(T), buf, left * sizeof(T));
+				}
+				else {
+					std::memcpy(buf, base + left * sizeof(T), right * sizeof(T));
+					std::memmove(base + right * sizeof(T), base, left * sizeof(T));
+					std::memcpy(base, buf, right * sizeof(T));
+				}
+				return first + static_cast<std::iter_difference_t<It>>(right);
+			}
+		}
+		relocate::reverse(first, middle);
+		relocate::reverse(middle, last);
+		// reverse the whole range and find where first ends up
+		It lo = first;
+		It hi = last;
+		while (lo != middle && hi != middle) {
+			relocate::swap(*lo, *--hi);
+			++lo;
+		}
+		if (lo == middle) {
+			relocate::reverse(middle, hi);
+			return hi;
+		}
+		relocate::reverse(lo, middle);
+		return lo;
+	}
+}
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloccount.h"
+#include "smfcount.h"
+
+// Section registry and timed runner
+// Every sec_*::run registers itself under its qualified name (see REGISTER_SECTION),
+// the runner selects sections by glob, runs them with warmup and repetitions
+// and reports wall time, allocations (if counted, see alloccount.h) and throughput per section.
+// Sections that read stdin (REGISTER_INTERACTIVE_SECTION) only run with --interactive.
+namespace sections
+{
+	using run_func = void (*)();
+
+	struct section {
+		std::string	name;					// qualified name, e.g. "chapter_7::sec_7_1_3::run"
+		run_func	func;
+		bool		interactive{ false };	// reads stdin, only runs with --interactive
+	};
+
+	// all registered sections in registration order
+	inline std::vector<section>& registry()
+	{
+		static std::vector<section> all;	// function local to avoid static initialization order problems
+		return all;
+	}
+
+	// registers a section during static initialization
+	struct registrar {
+		registrar(std::string name, run_func func, bool interactive = false)
+		{
+			registry().push_back(section{ std::move(name), func, interactive });
+		}
+	};
+
+	// match name against a glob pattern ('*' matches any sequence, '?' any single character)
+	inline bool glob_match(std::string_view pattern, std::string_view name)
+	{
+		std::size_t p = 0, n = 0;
+		std::size_t star = std::string_view::npos, mark = 0;
+		while (n < name.size()) {
+			if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+				++p;
+				++n;
+			}
+			else if (p < pattern.size() && pattern[p] == '*') {
+				star = p++;		// remember the star and try to match it with nothing first
+				mark = n;
+			}
+			else if (star != std::string_view::npos) {
+				p = star + 1;	// let the last star swallow one more character
+				n = ++mark;
+			}
+			else {
+				return false;
+			}
+		}
+		while (p < pattern.size() && pattern[p] == '*') {
+			++p;
+		}
+		return p == pattern.size();
+	}
+
+	struct options {
+		std::vector<std::string> patterns;	// globs selecting the sections (all if empty)
+		int		warmup{ 0 };				// untimed runs before measuring
+		int		reps{ 1 };					// timed runs
+		bool	quiet{ false };				// discard the output of the sections while they run
+		bool	list{ false };				// only list the selected sections
+		bool	json{ false };				// benchmarks report as JSON
+		bool	perf{ false };				// benchmarks count hardware events
+		bool	trace{ false };				// counted types print their copies and moves
+		bool	interactive{ false };		// also select the sections that read stdin
+		int		samples{ 0 };				// samples per benchmark (0: benchmark default)
+	};
+
+	struct result {
+		std::string					name;
+		int							reps{ 0 };
+		std::chrono::nanoseconds	total{ 0 };
+		std::chrono::nanoseconds	min{ std::chrono::nanoseconds::max() };
+		std::size_t					allocs{ 0 };	// allocations over all timed runs
+		std::size_t					bytes{ 0 };		// bytes allocated over all timed runs
+		std::size_t					peak{ 0 };		// maximum of the peak live bytes of the timed runs
+		bool						failed{ false };
+	};
+
+	// stream buffer that swallows everything (used for --quiet)
+	class null_buffer : public std::streambuf {
+	protected:
+		int_type overflow(int_type c) override {
+			return traits_type::not_eof(c);
+		}
+		std::streamsize xsputn(const char*, std::streamsize n) override {
+			return n;
+		}
+	};
+
+	inline void usage(std::ostream& strm, const char* prog)
+	{
+		strm << "usage: " << prog << " [options] [pattern...]\n"
+			 << "  pattern       glob over section names, e.g. 'chapter_7::*' (default: all)\n"
+			 << "  --list        list the selected sections and exit\n"
+			 << "  --interactive also run the sections that read stdin (skipped otherwise)\n"
+			 << "  --warmup N    untimed runs of each section before measuring (default: 0)\n"
+			 << "  --reps N      timed runs of each section (default: 1)\n"
+			 << "  --quiet       discard the output of the sections\n"
+			 << "  --trace       print copies and moves of counted types (slow)\n"
+			 << "  --json        benchmarks inside the sections report as JSON (summary to stderr)\n"
+			 << "  --samples N   samples per benchmark inside the sections\n"
+			 << "  --perf        benchmarks also count hardware events (Linux perf_event_open)\n";
+	}
+
+	// parse the command line into opts, returns false (after printing usage) on errors
+	inline bool parse_args(int argc, char* argv[], options& opts)
+	{
+		auto count_arg = [&](int& i, int& value, int min) {
+			if (i + 1 >= argc) {
+				return false;
+			}
+			char* end = nullptr;
+			long v = std::strtol(argv[++i], &end, 10);
+			if (*end != '\0' || v < min) {
+				return false;
+			}
+			value = static_cast<int>(v);
+			return true;
+		};
+
+		for (int i = 1; i < argc; ++i) {
+			std::string_view arg{ argv[i] };
+			bool ok = true;
+			if (arg == "--list") {
+				opts.list = true;
+			}
+			else if (arg == "--interactive") {
+				opts.interactive = true;
+			}
+			else if (arg == "--quiet") {
+				opts.quiet = true;
+			}
+			else if (arg == "--warmup") {
+				ok = count_arg(i, opts.warmup, 0);
+			}
+			else if (arg == "--reps") {
+				ok = count_arg(i, opts.reps, 1);
+			}
+			else if (arg == "--trace") {
+				opts.trace = true;
+			}
+			else if (arg == "--json") {
+				opts.json = true;
+			}
+			else if (arg == "--perf") {
+				opts.perf = true;
+			}
+			else if (arg == "--samples") {
+				ok = count_arg(i, opts.samples, 1);
+			}
+			else if (arg == "--help" || arg == "-h") {
+				usage(std::cout, argv[0]);
+				return false;
+			}
+			else if (arg.size() > 1 && arg[0] == '-') {
+				ok = false;
+			}
+			else {
+				opts.patterns.emplace_back(arg);
+			}
+			if (!ok) {
+				std::cerr << "invalid argument: " << arg << '\n';
+				usage(std::cerr, argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline std::vector<const section*> select(const std::vector<std::string>& patterns, bool interactive = false)
+	{
+		std::vector<const section*> selected;
+		for (const section& sec : registry()) {
+			if (sec.interactive && !interactive) {
+				continue;	// would wait for input
+			}
+			bool match = patterns.empty();
+			for (const std::string& pattern : patterns) {
+				match = match || glob_match(pattern, sec.name);
+			}
+			if (match) {
+				selected.push_back(&sec);
+			}
+		}
+		return selected;
+	}
+
+	// run a single section with warmup and repetitions
+	inline result measure(const section& sec, const options& opts)
+	{
+		result res{ sec.name };
+		try {
+			for (int i = 0; i < opts.warmup; ++i) {
+				sec.func();
+			}
+			for (int i = 0; i < opts.reps; ++i) {
+				alloccount::scope allocs;
+				auto t0 = std::chrono::steady_clock::now();
+				sec.func();
+				auto t1 = std::chrono::steady_clock::now();
+				alloccount::stats used = allocs.current();
+
+				std::chrono::nanoseconds dur{ t1 - t0 };
+				res.total += dur;
+				res.min = std::min(res.min, dur);
+				res.allocs += used.count;
+				res.bytes += used.bytes;
+				res.peak = std::max(res.peak, used.peak);
+				++res.reps;
+			}
+		}
+		catch (const std::exception& e) {
+			std::cerr << sec.name << " FAILED: " << e.what() << '\n';
+			res.failed = true;
+		}
+		catch (...) {
+			std::cerr << sec.name << " FAILED: unknown exception\n";
+			res.failed = true;
+		}
+		return res;
+	}
+
+	inline void report(std::ostream& strm, const std::vector<result>& results)
+	{
+		std::size_t width = 8;
+		for (const result& res : results) {
+			width = std::max(width, res.name.size());
+		}
+
+		strm << std::left << std::setw(static_cast<int>(width)) << "section" << std::right
+			 << std::setw(6) << "reps"
+			 << std::setw(12) << "total ms"
+			 << std::setw(12) << "avg ms"
+			 << std::setw(12) << "min ms"
+			 << std::setw(12) << "runs/s"
+			 << std::setw(12) << "allocs/run"
+			 << std::setw(12) << "KiB/run"
+			 << std::setw(12) << "peak KiB" << '\n';
+
+		for (const result& res : results) {
+			strm << std::left << std::setw(static_cast<int>(width)) << res.name << std::right;
+			if (res.failed || res.reps == 0) {
+				strm << "  FAILED\n";
+				continue;
+			}
+			std::chrono::duration<double, std::milli> total{ res.total };
+			std::chrono::duration<double, std::milli> min{ res.min };
+			std::chrono::duration<double> secs{ res.total };
+			strm << std::fixed << std::setprecision(3)
+				 << std::setw(6) << res.reps
+				 << std::setw(12) << total.count()
+				 << std::setw(12) << total.count() / res.reps
+				 << std::setw(12) << min.count()
+				 << std::setprecision(1)
+				 << std::setw(12) << (secs.count() > 0 ? res.reps / secs.count() : 0.0);
+			if (alloccount::installed()) {
+				strm << std::setw(12) << res.allocs / res.reps
+					 << std::setw(12) << static_cast<double>(res.bytes) / res.reps / 1024
+					 << std::setw(12) << static_cast<double>(res.peak) / 1024;
+			}
+			else {
+				strm << std::setw(12) << "n/a" << std::setw(12) << "n/a" << std::setw(12) << "n/a";
+			}
+			strm << '\n';
+		}
+		strm << std::defaultfloat;
+	}
+
+	// run all sections selected by opts, returns the process exit code
+	inline int run(const options& opts)
+	{
+		std::vector<const section*> selected = select(opts.patterns, opts.interactive);
+		if (selected.empty()) {
+			bool interactive_only = !opts.interactive && !select(opts.patterns, true).empty();
+			std::cerr << (interactive_only ? "only sections that read stdin match (use --interactive)\n" : "no section matches\n");
+			return 1;
+		}
+		if (opts.list) {
+			for (const section* sec : selected) {
+				std::cout << sec->name << '\n';
+			}
+			return 0;
+		}
+
+		null_buffer null_buf;
+		std::vector<result> results;
+		results.reserve(selected.size());
+		for (const section* sec : selected) {
+			std::streambuf* old_buf = opts.quiet ? std::cout.rdbuf(&null_buf) : nullptr;
+			results.push_back(measure(*sec, opts));
+			if (old_buf) {
+				std::cout.rdbuf(old_buf);
+			}
+		}
+
+		// with --json stdout carries only the output of the sections
+		std::ostream& summary = opts.json ? std::cerr : std::cout;
+		summary << std::endl;
+		report(summary, results);
+		if (smfcount::types().load()) {
+			summary << std::endl;
+			smfcount::report(summary);
+		}
+
+		for (const result& res : results) {
+			if (res.failed) {
+				return 1;
+			}
+		}
+		return 0;
+	}
+}
+
+#define SECTIONS_CONCAT_IMPL(a, b) a##b
+#define SECTIONS_CONCAT(a, b) SECTIONS_CONCAT_IMPL(a, b)
+
+// register a section function under its qualified name
+#define REGISTER_SECTION(func) \
+	static const sections::registrar SECTIONS_CONCAT(section_registrar_, __LINE__){ #func, &func }
+
+// register a section that reads stdin (selected only with --interactive)
+#define REGISTER_INTERACTIVE_SECTION(func) \
+	static const sections::registrar SECTIONS_CONCAT(section_registrar_, __LINE__){ #func, &func, true }
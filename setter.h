@@ -0,0 +1,74 @@
+#pragma once
+
+#include <concepts>
+#include <utility>
+
+// Setter policies
+// How a setter takes its argument decides whether assigning keeps the capacity the member
+// already has (chapter_4::sec_4_3_6):
+//
+//		by_value		set(T v) { m = std::move(v); }		one function, but the argument is
+//															built first and its buffer replaces
+//															the member's (capacity is lost)
+//		overload_pair	set(const T&) / set(T&&)			lvalues are assigned (capacity kept),
+//															rvalues moved; const char* still
+//															creates a temporary
+//		forward_assign	template set(U&& v)					everything is assigned straight from
+//															the argument (m = "literal" reuses the
+//															buffer if it is large enough)
+//
+// field<T, Policy> holds a member and has the setter of the policy, so the policy can be
+// chosen per member; a class forwards its setters to it:
+//
+//		setter::field<std::string, setter::forward_assign> m_first;
+//		template <typename S>
+//		void set_first_name(S&& s) { m_first.set(std::forward<S>(s)); }
+//
+// Forwarding keeps the semantics of the policy: the argument is converted (or copied) only
+// where the policy does it.
+namespace setter
+{
+	struct by_value {};
+	struct overload_pair {};
+	struct forward_assign {};
+
+	template <typename T, typename Policy = forward_assign>
+	class field {
+	private:
+		T m_value;
+
+	public:
+		field() = default;
+		template <typename... Args>
+			requires std::constructible_from<T, Args...>
+		explicit field(Args&&... args)
+			: m_value(std::forward<Args>(args)...)
+		{}
+
+		const T& get() const noexcept
+		{
+			return m_value;
+		}
+
+		void set(T val) requires std::same_as<Policy, by_value>
+		{
+			m_value = std::move(val);
+		}
+
+		void set(const T& val) requires std::same_as<Policy, overload_pair>
+		{
+			m_value = val;
+		}
+		void set(T&& val) requires std::same_as<Policy, overload_pair>
+		{
+			m_value = std::move(val);
+		}
+
+		template <typename U>
+			requires std::same_as<Policy, forward_assign> && std::assignable_from<T&, U&&>
+		void set(U&& val)
+		{
+			m_value = std::forward<U>(val);
+		}
+	};
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Vector with inline storage for the first N elements
+// Up to N elements live inside the object, so small collections (e.g. the 10 values of
+// chapter_3::sec_3_1::create_customer()) need no heap allocation and no pointer chase
+// to a separate block. Beyond N the elements move to the heap like in a std::vector.
+// Moving copies (moves) the inline elements but steals the heap block:
+//
+//		smallvector::small_vector<int, 10> v1{ 0, 8, 15 };
+//		auto v2 = std::move(v1);		// copies 3 ints, v1 is empty afterwards
+//
+// The object points into itself while the elements are inline, so it is not trivially
+// relocatable (see relocate.h).
+namespace smallvector
+{
+	template <typename T, std::size_t N>
+	class small_vector {
+	private:
+		T*			m_data;
+		std::size_t	m_size{ 0 };
+		std::size_t	m_capacity{ N };
+		alignas(T) unsigned char m_inline[N > 0 ? N * sizeof(T) : 1];
+
+		T* inline_data() noexcept
+		{
+			return std::launder(reinterpret_cast<T*>(m_inline));
+		}
+
+		static T* allocate(std::size_t cap)
+		{
+			if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+				return static_cast<T*>(::operator new(cap * sizeof(T), std::align_val_t{ alignof(T) }));
+			}
+			else {
+				return static_cast<T*>(::operator new(cap * sizeof(T)));
+			}
+		}
+		static void deallocate(T* block) noexcept
+		{
+			if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+				::operator delete(block, std::align_val_t{ alignof(T) });
+			}
+			else {
+				::operator delete(block);
+			}
+		}
+
+		// move the elements to a heap block of cap elements
+		void reallocate(std::size_t cap)
+		{
+			T* block = allocate(cap);
+			if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+				std::uninitialized_move(m_data, m_data + m_size, block);
+			}
+			else {
+				try {
+					std::uninitialized_copy(m_data, m_data + m_size, block);	// keep the strong guarantee
+				}
+				catch (...) {
+					deallocate(block);
+					throw;
+				}
+			}
+			std::destroy(m_data, m_data + m_size);
+			release();
+			m_data = block;
+			m_capacity = cap;
+		}
+
+		void release() noexcept
+		{
+			if (!is_inline()) {
+				deallocate(m_data);
+			}
+		}
+
+		// take the elements of v (steal its heap block or move its inline elements)
+		void take(small_vector& v) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (v.is_inline()) {
+				std::uninitialized_move(v.m_data, v.m_data + v.m_size, m_data);
+				m_size = v.m_size;
+				v.clear();
+			}
+			else {
+				m_data = std::exchange(v.m_data, v.inline_data());
+				m_size = std::exchange(v.m_size, 0);
+				m_capacity = std::exchange(v.m_capacity, N);
+			}
+		}
+
+	public:
+		using value_type = T;
+		using size_type = std::size_t;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		small_vector() noexcept
+			: m_data{ inline_data() }
+		{}
+		small_vector(std::initializer_list<T> il)
+			: small_vector()
+		{
+			reserve(il.size());
+			for (const T& elem : il) {
+				emplace_back(elem);
+			}
+		}
+		small_vector(const small_vector& v)
+			: small_vector()
+		{
+			reserve(v.m_size);
+			std::uninitialized_copy(v.begin(), v.end(), m_data);
+			m_size = v.m_size;
+		}
+		small_vector(small_vector&& v) noexcept(std::is_nothrow_move_constructible_v<T>)
+			: small_vector()
+		{
+			take(v);
+		}
+		small_vector& operator= (const small_vector& v)
+		{
+			if (this != &v) {
+				small_vector tmp{ v };
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		small_vector& operator= (small_vector&& v) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (this != &v) {
+				clear();
+				release();
+				m_data = inline_data();
+				m_capacity = N;
+				take(v);
+			}
+			return *this;
+		}
+		~small_vector()
+		{
+			clear();
+			release();
+		}
+
+		void reserve(std::size_t cap)
+		{
+			if (cap > m_capacity) {
+				reallocate(cap);
+			}
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (m_size == m_capacity) {
+				// construct first, args might refer to an element
+				T elem(std::forward<Args>(args)...);
+				reallocate(std::max<std::size_t>(2 * m_capacity, 1));
+				::new (static_cast<void*>(m_data + m_size)) T(std::move(elem));
+			}
+			else {
+				::new (static_cast<void*>(m_data + m_size)) T(std::forward<Args>(args)...);
+			}
+			return m_data[m_size++];
+		}
+		void push_back(const T& elem)
+		{
+			emplace_back(elem);
+		}
+		void push_back(T&& elem)
+		{
+			emplace_back(std::move(elem));
+		}
+		void pop_back() noexcept
+		{
+			assert(m_size > 0);
+			std::destroy_at(m_data + --m_size);
+		}
+		void clear() noexcept
+		{
+			std::destroy(m_data, m_data + m_size);
+			m_size = 0;
+		}
+
+		bool is_inline() const noexcept
+		{
+			return m_data == reinterpret_cast<const T*>(m_inline);
+		}
+		static constexpr std::size_t inline_capacity() noexcept
+		{
+			return N;
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+		std::size_t capacity() const noexcept
+		{
+			return m_capacity;
+		}
+		bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+		T* data() noexcept
+		{
+			return m_data;
+		}
+		const T* data() const noexcept
+		{
+			return m_data;
+		}
+		iterator begin() noexcept
+		{
+			return m_data;
+		}
+		iterator end() noexcept
+		{
+			return m_data + m_size;
+		}
+		const_iterator begin() const noexcept
+		{
+			return m_data;
+		}
+		const_iterator end() const noexcept
+		{
+			return m_data + m_size;
+		}
+		T& operator[] (std::size_t idx) noexcept
+		{
+			return m_data[idx];
+		}
+		const T& operator[] (std::size_t idx) const noexcept
+		{
+			return m_data[idx];
+		}
+		T& back() noexcept
+		{
+			return m_data[m_size - 1];
+		}
+		const T& back() const noexcept
+		{
+			return m_data[m_size - 1];
+		}
+
+		friend bool operator== (const small_vector& a, const small_vector& b)
+		{
+			return std::equal(a.begin(), a.end(), b.begin(), b.end());
+		}
+	};
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+// Special member function counters
+// Derive a class from smfcount::counted<Class> to count its constructions, copies, moves,
+// assignments and destructions without any I/O:
+//
+//		class Person : public smfcount::counted<Person> { ... };
+//
+// Defaulted special member functions count automatically, user provided ones have to
+// pass the source to the base (e.g. Person(const Person& p) : counted{ p }, ...).
+// Counting increments plain thread local counters, they are added to the process wide
+// totals when a thread exits (or when the calling thread asks for totals/report).
+namespace smfcount
+{
+	enum event : std::size_t {
+		construct, copy_construct, move_construct, copy_assign, move_assign, destroy, num_events
+	};
+
+	inline constexpr const char* event_names[num_events]{
+		"ctor", "copy ctor", "move ctor", "copy assign", "move assign", "dtor"
+	};
+
+	using tally = std::array<std::size_t, num_events>;
+
+	// one entry per counted type, linked into a lock-free list on first use
+	struct type_entry {
+		std::string		(*name)();
+		tally			(*local)();			// counts of the calling thread not flushed yet
+		type_entry*		next{ nullptr };
+		std::array<std::atomic<std::size_t>, num_events> flushed{};	// counts of exited threads
+	};
+
+	inline std::atomic<type_entry*>& types()
+	{
+		static std::atomic<type_entry*> head{ nullptr };
+		return head;
+	}
+
+	// print COPY/MOVE traces (as the examples of the book do) instead of only counting
+	inline std::atomic<bool>& tracing()
+	{
+		static std::atomic<bool> on{ false };
+		return on;
+	}
+
+	// readable name of type T
+	template <typename T>
+	std::string type_name()
+	{
+		std::string name = typeid(T).name();
+#if defined(__GNUC__) || defined(__clang__)
+		int status = 0;
+		if (char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status)) {
+			name = demangled;
+			std::free(demangled);
+		}
+#else
+		for (std::string prefix : { "class ", "struct " }) {
+			if (name.compare(0, prefix.size(), prefix) == 0) {
+				name.erase(0, prefix.size());
+			}
+		}
+#endif
+		return name;
+	}
+
+	template <typename T>
+	class counted {
+	private:
+		struct local_block {
+			tally counts{};
+			local_block()
+			{
+				entry();	// registers the type on first use
+			}
+			~local_block()
+			{
+				type_entry& e = entry();
+				for (std::size_t i = 0; i < num_events; ++i) {
+					e.flushed[i].fetch_add(counts[i], std::memory_order_relaxed);
+				}
+			}
+		};
+
+		static type_entry& entry()
+		{
+			static type_entry& e = link(new type_entry{ &type_name<T>, &local_counts });	// never deleted (used at thread exit)
+			return e;
+		}
+
+		static type_entry& link(type_entry* e)
+		{
+			std::atomic<type_entry*>& head = types();
+			e->next = head.load(std::memory_order_relaxed);
+			while (!head.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed)) {
+			}
+			return *e;
+		}
+
+		static local_block& local()
+		{
+			thread_local local_block block;
+			return block;
+		}
+
+		static tally local_counts()
+		{
+			return local().counts;
+		}
+
+		static void record(event ev) noexcept
+		{
+			++local().counts[ev];
+		}
+
+	protected:
+		counted() noexcept
+		{
+			record(construct);
+		}
+		counted(const counted&) noexcept
+		{
+			record(copy_construct);
+		}
+		counted(counted&&) noexcept
+		{
+			record(move_construct);
+		}
+		counted& operator= (const counted&) noexcept
+		{
+			record(copy_assign);
+			return *this;
+		}
+		counted& operator= (counted&&) noexcept
+		{
+			record(move_assign);
+			return *this;
+		}
+		~counted()
+		{
+			record(destroy);
+		}
+
+		// print what and name if tracing is enabled (not noexcept, it performs I/O)
+		static void trace(const char* what, const std::string& name)
+		{
+			if (tracing().load(std::memory_order_relaxed)) {
+				std::cout << what << name << '\n';
+			}
+		}
+
+	public:
+		// counts of all exited threads and the calling thread
+		static tally totals()
+		{
+			tally res = local_counts();
+			type_entry& e = entry();
+			for (std::size_t i = 0; i < num_events; ++i) {
+				res[i] += e.flushed[i].load(std::memory_order_relaxed);
+			}
+			return res;
+		}
+	};
+
+	// print a table with the counts of all types used so far
+	inline void report(std::ostream& strm)
+	{
+		struct row {
+			std::string name;
+			tally counts;
+		};
+		std::vector<row> rows;
+		std::size_t width = 4;
+		for (type_entry* e = types().load(std::memory_order_acquire); e; e = e->next) {
+			row r{ e->name(), e->local() };
+			for (std::size_t i = 0; i < num_events; ++i) {
+				r.counts[i] += e->flushed[i].load(std::memory_order_relaxed);
+			}
+			width = std::max(width, r.name.size());
+			rows.push_back(std::move(r));
+		}
+		if (rows.empty()) {
+			return;
+		}
+
+		strm << std::left << std::setw(static_cast<int>(width)) << "type" << std::right;
+		for (const char* name : event_names) {
+			strm << std::setw(13) << name;
+		}
+		strm << '\n';
+		// the list is in reverse order of first use
+		for (auto r = rows.rbegin(); r != rows.rend(); ++r) {
+			strm << std::left << std::setw(static_cast<int>(width)) << r->name << std::right;
+			for (std::size_t count : r->counts) {
+				strm << std::setw(13) << count;
+			}
+			strm << '\n';
+		}
+	}
+}
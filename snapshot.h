@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "linereader.h"
+#include "parallel.h"
+
+// Binary customer snapshots
+// Rebuilding a std::vector<Customer> from text parses every name and value again.
+// A snapshot stores the customers in columns (like customertable.h) in one file:
+//
+//		header		magic, version, byte order, number of customers, names and values
+//		name_end	uint64 per customer: end of its name in the name arena
+//		value_end	uint64 per customer: end of its values in the value arena
+//		values		int (32 bit) value arena
+//		names		character arena
+//
+// save()/write() stream the customers out (only the offset tables are built in memory).
+// load() maps the file and checks the header and the offset tables; there is nothing to
+// parse, rows are views into the mapping. to_customers() move-constructs real customer
+// objects from the views in bulk (on several threads):
+//
+//		snapshot::save("customers.snap", coll);
+//		snapshot::file snap = snapshot::file::load("customers.snap");
+//		std::string_view name = snap[0].get_name();
+//		std::vector<Customer> again = snap.to_customers<Customer>();
+//
+// The format uses the byte order of the writer; files of the other byte order are rejected
+// (as are truncated or inconsistent files, with std::runtime_error).
+namespace snapshot
+{
+	inline constexpr char magic[8] = { 'C', 'U', 'S', 'T', 'S', 'N', 'A', 'P' };
+	inline constexpr std::uint32_t version = 1;
+	inline constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+	struct header {
+		char			magic[8];
+		std::uint32_t	version;
+		std::uint32_t	byte_order;
+		std::uint64_t	customers;
+		std::uint64_t	name_bytes;
+		std::uint64_t	values;
+	};
+	static_assert(sizeof(header) % alignof(std::uint64_t) == 0);
+	static_assert(sizeof(int) == 4, "values are stored as 32 bit ints");
+
+	namespace detail
+	{
+		template <typename T>
+		void write_raw(std::ostream& strm, const T* data, std::size_t num)
+		{
+			strm.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(num * sizeof(T)));
+		}
+	}
+
+	// write the customers (anything with get_name() and contiguous get_values()) to strm
+	template <typename Customers>
+	void write(std::ostream& strm, const Customers& coll)
+	{
+		std::vector<std::uint64_t> name_end;
+		std::vector<std::uint64_t> value_end;
+		name_end.reserve(std::size(coll));
+		value_end.reserve(std::size(coll));
+		std::uint64_t names = 0;
+		std::uint64_t values = 0;
+		for (const auto& cust : coll) {
+			names += std::string_view{ cust.get_name() }.size();
+			values += std::size(cust.get_values());
+			name_end.push_back(names);
+			value_end.push_back(values);
+		}
+
+		header head{};
+		std::memcpy(head.magic, magic, sizeof(magic));
+		head.version = version;
+		head.byte_order = byte_order_mark;
+		head.customers = name_end.size();
+		head.name_bytes = names;
+		head.values = values;
+		detail::write_raw(strm, &head, 1);
+		detail::write_raw(strm, name_end.data(), name_end.size());
+		detail::write_raw(strm, value_end.data(), value_end.size());
+		for (const auto& cust : coll) {
+			const auto& vals = cust.get_values();
+			static_assert(std::is_same_v<std::remove_cvref_t<decltype(*std::data(vals))>, int>);
+			detail::write_raw(strm, std::data(vals), std::size(vals));
+		}
+		for (const auto& cust : coll) {
+			const auto& name = cust.get_name();
+			strm.write(std::data(name), static_cast<std::streamsize>(std::size(name)));
+		}
+	}
+
+	// write the customers to the file path (throws std::system_error on failure)
+	template <typename Customers>
+	void save(const std::string& path, const Customers& coll)
+	{
+		std::ofstream strm{ path, std::ios::binary | std::ios::trunc };
+		if (!strm) {
+			throw std::system_error{ std::make_error_code(std::errc::io_error), "cannot create " + path };
+		}
+		write(strm, coll);
+		strm.close();
+		if (!strm) {
+			throw std::system_error{ std::make_error_code(std::errc::io_error), "cannot write " + path };
+		}
+	}
+
+	// a loaded snapshot (move-only, rows are views into it)
+	class file {
+	private:
+		linereader::buffer		m_buf;
+		std::size_t				m_size{ 0 };
+		const std::uint64_t*	m_name_end{ nullptr };
+		const std::uint64_t*	m_value_end{ nullptr };
+		const int*		m_values{ nullptr };
+		const char*				m_names{ nullptr };
+		std::size_t				m_num_values{ 0 };
+
+		[[noreturn]] static void invalid(const std::string& what)
+		{
+			throw std::runtime_error{ "invalid customer snapshot: " + what };
+		}
+
+		// the sections are views into the buffer (O(n) check of the offset tables, no parsing)
+		explicit file(linereader::buffer&& buf)
+			: m_buf{ std::move(buf) }
+		{
+			std::string_view bytes = m_buf.view();
+			header head;
+			if (bytes.size() < sizeof(head)) {
+				invalid("truncated header");
+			}
+			std::memcpy(&head, bytes.data(), sizeof(head));
+			if (std::memcmp(head.magic, magic, sizeof(magic)) != 0) {
+				invalid("wrong magic");
+			}
+			if (head.byte_order != byte_order_mark) {
+				invalid("wrong byte order");
+			}
+			if (head.version != version) {
+				invalid("version " + std::to_string(head.version));
+			}
+			if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(std::uint64_t) != 0) {
+				invalid("misaligned buffer");
+			}
+			std::uint64_t rest = bytes.size() - sizeof(head);
+			if (head.customers > rest / (2 * sizeof(std::uint64_t))
+				|| head.values > (rest - head.customers * 2 * sizeof(std::uint64_t)) / sizeof(int)
+				|| head.name_bytes != rest - head.customers * 2 * sizeof(std::uint64_t) - head.values * sizeof(int)) {
+				invalid("size does not match the header");
+			}
+
+			m_size = static_cast<std::size_t>(head.customers);
+			m_num_values = static_cast<std::size_t>(head.values);
+			const char* pos = bytes.data() + sizeof(head);
+			m_name_end = reinterpret_cast<const std::uint64_t*>(pos);
+			m_value_end = m_name_end + m_size;
+			m_values = reinterpret_cast<const int*>(m_value_end + m_size);
+			m_names = reinterpret_cast<const char*>(m_values + m_num_values);
+
+			std::uint64_t names = 0;
+			std::uint64_t values = 0;
+			for (std::size_t i = 0; i < m_size; ++i) {
+				if (m_name_end[i] < names || m_value_end[i] < values) {
+					invalid("offsets of customer " + std::to_string(i));
+				}
+				names = m_name_end[i];
+				values = m_value_end[i];
+			}
+			if (names != head.name_bytes || values != head.values) {
+				invalid("offset tables do not match the header");
+			}
+		}
+
+	public:
+		class row;
+
+		// map the file path read-only
+		static file load(const std::string& path)
+		{
+			return file{ linereader::buffer::map(path) };
+		}
+		// read strm up to its end
+		static file read(std::istream& strm)
+		{
+			return file{ linereader::buffer::slurp(strm) };
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_size;
+		}
+		bool empty() const noexcept
+		{
+			return m_size == 0;
+		}
+		bool mapped() const noexcept
+		{
+			return m_buf.mapped();
+		}
+
+		std::string_view name(std::size_t idx) const noexcept
+		{
+			std::size_t begin = idx > 0 ? static_cast<std::size_t>(m_name_end[idx - 1]) : 0;
+			return { m_names + begin, static_cast<std::size_t>(m_name_end[idx]) - begin };
+		}
+		std::span<const int> values(std::size_t idx) const noexcept
+		{
+			std::size_t begin = idx > 0 ? static_cast<std::size_t>(m_value_end[idx - 1]) : 0;
+			return { m_values + begin, static_cast<std::size_t>(m_value_end[idx]) - begin };
+		}
+		// the values of all customers in row order
+		std::span<const int> all_values() const noexcept
+		{
+			return { m_values, m_num_values };
+		}
+
+		row operator[] (std::size_t idx) const noexcept;
+
+		// owning objects (C needs a constructor from the name and either the values as
+		// std::vector<int> or add_value()), made by threads workers (0: one per hardware thread)
+		template <typename C>
+		std::vector<C> to_customers(unsigned threads = 0) const
+		{
+			constexpr std::size_t min_chunk = 4096;		// not worth a thread below
+			if (threads == 0) {
+				threads = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+			std::size_t parts = std::clamp<std::size_t>(m_size / min_chunk, 1, threads);
+			std::vector<std::vector<C>> chunks(parts);
+			parallel::parallel_for(parts, [&](std::size_t part) {
+				std::size_t first = m_size * part / parts;
+				std::size_t last = m_size * (part + 1) / parts;
+				chunks[part].reserve(part == 0 ? m_size : last - first);	// the first chunk becomes the result
+				for (std::size_t i = first; i < last; ++i) {
+					std::span<const int> vals = values(i);
+					if constexpr (std::is_constructible_v<C, std::string, std::vector<int>>) {
+						chunks[part].emplace_back(std::string{ name(i) }, std::vector<int>(vals.begin(), vals.end()));
+					}
+					else {
+						C cust{ std::string{ name(i) } };
+						for (int val : vals) {
+							cust.add_value(val);
+						}
+						chunks[part].push_back(std::move(cust));
+					}
+				}
+			});
+			std::vector<C> res = std::move(chunks[0]);
+			for (std::size_t part = 1; part < parts; ++part) {
+				std::move(chunks[part].begin(), chunks[part].end(), std::back_inserter(res));
+			}
+			return res;
+		}
+	};
+
+	// a customer in the snapshot with the read interface of Customer
+	class file::row {
+	private:
+		const file*	m_file;
+		std::size_t	m_idx;
+	public:
+		row(const file& snap, std::size_t idx)
+			: m_file{ &snap }, m_idx{ idx }
+		{}
+
+		std::string_view get_name() const
+		{
+			return m_file->name(m_idx);
+		}
+		std::span<const int> get_values() const
+		{
+			return m_file->values(m_idx);
+		}
+		std::size_t index() const
+		{
+			return m_idx;
+		}
+
+		friend std::ostream& operator<< (std::ostream& strm, const row& r)
+		{
+			strm << '[' << r.get_name() << ": ";
+			for (int val : r.get_values()) {
+				strm << val << ' ';
+			}
+			strm << ']';
+			return strm;
+		}
+	};
+
+	inline file::row file::operator[] (std::size_t idx) const noexcept
+	{
+		return { *this, idx };
+	}
+}
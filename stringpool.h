@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Recycling string pool
+// In a loop like
+//
+//		while (std::getline(std::cin, row)) {
+//			all_rows.push_back(std::move(row));		// row is empty (without a buffer) afterwards
+//		}
+//
+// every row starts without a buffer and allocates again. The pool hands out strings
+// that already have a buffer and takes the buffers back when the rows are consumed,
+// so a long running loop reaches a steady state without any allocation:
+//
+//		stringpool::pool pool;
+//		std::string row = pool.acquire();
+//		while (std::getline(std::cin, row)) {
+//			batch.push_back(std::move(row));
+//			row = pool.acquire();
+//			...
+//			pool.release(batch);			// after the batch was processed
+//		}
+//
+// A pool is not thread-safe, use one per thread.
+namespace stringpool
+{
+	struct stats {
+		std::size_t	hits{ 0 };			// acquire() returned a recycled string
+		std::size_t	misses{ 0 };		// acquire() had to allocate
+		std::size_t	recycled{ 0 };		// released strings kept for reuse
+		std::size_t	discarded{ 0 };		// released strings dropped (no buffer or pool full)
+
+		double hit_rate() const
+		{
+			std::size_t total = hits + misses;
+			return total > 0 ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+		}
+	};
+
+	class pool {
+	private:
+		std::vector<std::string>	m_free;
+		std::size_t					m_reserve;		// capacity of new strings
+		std::size_t					m_max_free;		// strings kept at most
+		stringpool::stats			m_stats;
+	public:
+		explicit pool(std::size_t reserve = 128, std::size_t max_free = 4096)
+			: m_reserve{ reserve }, m_max_free{ max_free }
+		{
+			m_free.reserve(max_free);	// so release() never allocates
+		}
+
+		// an empty string with a buffer of at least the reserved capacity
+		std::string acquire()
+		{
+			if (!m_free.empty()) {
+				++m_stats.hits;
+				std::string str = std::move(m_free.back());
+				m_free.pop_back();
+				return str;
+			}
+			++m_stats.misses;
+			std::string str;
+			str.reserve(m_reserve);
+			return str;
+		}
+
+		// take the buffer of str back and leave str empty
+		// (strings without a heap buffer are not worth keeping)
+		void release(std::string&& str) noexcept
+		{
+			if (m_free.size() < m_max_free && str.capacity() >= m_reserve) {
+				str.clear();
+				m_free.push_back(std::move(str));
+				++m_stats.recycled;
+			}
+			else {
+				++m_stats.discarded;
+			}
+			str.clear();
+		}
+
+		// take back all strings of coll and leave it empty
+		void release(std::vector<std::string>& coll) noexcept
+		{
+			for (std::string& str : coll) {
+				release(std::move(str));
+			}
+			coll.clear();
+		}
+
+		// pre-fill the pool with num strings (counted neither as hits nor misses)
+		void prime(std::size_t num)
+		{
+			while (m_free.size() < m_max_free && num-- > 0) {
+				std::string str;
+				str.reserve(m_reserve);
+				m_free.push_back(std::move(str));
+			}
+		}
+
+		std::size_t available() const noexcept
+		{
+			return m_free.size();
+		}
+		const stringpool::stats& stats() const noexcept
+		{
+			return m_stats;
+		}
+		void reset_stats() noexcept
+		{
+			m_stats = stringpool::stats{};
+		}
+	};
+}